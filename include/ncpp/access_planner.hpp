@@ -0,0 +1,270 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_ACCESS_PLANNER_HPP
+#define NCPP_ACCESS_PLANNER_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <netcdf.h>
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/functions/ndarray.hpp>
+#include <ncpp/functions/variable.hpp>
+#include <ncpp/iterator.hpp>
+#include <ncpp/variable.hpp>
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+
+namespace ncpp {
+namespace detail {
+
+// Read of a hyperslab into caller-owned memory.
+struct planned_read
+{
+    planned_read(int ncid, int varid, std::type_index type, const index_type& start,
+                 const index_type& count, const stride_type& stride)
+        : ncid(ncid), varid(varid), type(type), start(start), count(count), stride(stride)
+    {}
+
+    virtual ~planned_read() = default;
+
+    // Read the chunks intersecting a group of requests with the same
+    // variable and type as this one.
+    virtual void execute(const std::vector<planned_read *>& group) const = 0;
+
+    int ncid;
+    int varid;
+    std::type_index type;
+    index_type start;
+    index_type count;
+    stride_type stride;
+};
+
+template <class T>
+struct typed_planned_read : planned_read
+{
+    typed_planned_read(int ncid, int varid, const index_type& start, const index_type& count,
+                       const stride_type& stride, T *out)
+        : planned_read(ncid, varid, std::type_index(typeid(T)), start, count, stride), out(out)
+    {}
+
+    // Part of a request within one chunk.
+    struct piece
+    {
+        index_type chunk;       // chunk index
+        const typed_planned_read *request;
+        index_type position;    // position in the request
+        index_type count;
+    };
+
+    void execute(const std::vector<planned_read *>& group) const override
+    {
+        const std::size_t ndims = count.size();
+        index_type chunkshape = chunk_iterator::default_chunkshape(ncid, varid);
+        for (auto& n : chunkshape)
+            n = std::max<std::size_t>(n, 1);
+
+        // Split each request at chunk boundaries.
+        std::vector<piece> pieces;
+        for (const planned_read *p : group) {
+            const auto *r = static_cast<const typed_planned_read *>(p);
+            if (api::compute_size(r->count) == 0)
+                continue;
+
+            std::vector<std::vector<std::pair<std::size_t, std::size_t>>> segments(ndims);
+            for (std::size_t d = 0; d < ndims; ++d)
+                segments[d] = api::compute_chunk_segments(r->start[d], r->count[d], r->stride[d], chunkshape[d]);
+
+            index_type k(ndims, 0);
+            for (;;) {
+                piece s{ index_type(ndims), r, index_type(ndims), index_type(ndims) };
+                for (std::size_t d = 0; d < ndims; ++d) {
+                    s.position[d] = segments[d][k[d]].first;
+                    s.count[d] = segments[d][k[d]].second;
+                    s.chunk[d] = (r->start[d] + s.position[d] * static_cast<std::size_t>(r->stride[d])) / chunkshape[d];
+                }
+                pieces.push_back(std::move(s));
+
+                std::size_t d = ndims;
+                for (; d != 0; --d) {
+                    if (++k[d-1] < segments[d-1].size())
+                        break;
+                    k[d-1] = 0;
+                }
+                if (d == 0)
+                    break;
+            }
+        }
+
+        // Visit the chunks in storage order.
+        std::stable_sort(pieces.begin(), pieces.end(),
+            [](const piece& a, const piece& b) { return a.chunk < b.chunk; });
+
+        const stride_type unit(ndims, 1);
+        std::vector<T> buffer;
+        for (auto first = pieces.begin(); first != pieces.end(); /**/) {
+            auto last = std::find_if(first, pieces.end(),
+                [&](const piece& s) { return s.chunk != first->chunk; });
+
+            // Read the bounding box of the pieces within the chunk once.
+            index_type lower(ndims), upper(ndims);
+            for (std::size_t d = 0; d < ndims; ++d) {
+                lower[d] = upper[d] = element(*first, d, 0);
+                for (auto it = first; it != last; ++it) {
+                    lower[d] = std::min(lower[d], element(*it, d, 0));
+                    upper[d] = std::max(upper[d], element(*it, d, it->count[d] - 1));
+                }
+            }
+            index_type bcount(ndims);
+            for (std::size_t d = 0; d < ndims; ++d)
+                bcount[d] = upper[d] - lower[d] + 1;
+
+            buffer.resize(api::compute_size(bcount));
+            check(api::impl::detail::get_vars(ncid, varid, lower.data(), bcount.data(), unit.data(), buffer.data()));
+
+            for (auto it = first; it != last; ++it)
+                copy(*it, lower, bcount, buffer.data());
+            first = last;
+        }
+    }
+
+    // Get the file index of an element of a piece along a dimension.
+    static std::size_t element(const piece& s, std::size_t d, std::size_t j)
+    {
+        return s.request->start[d] + (s.position[d] + j) * static_cast<std::size_t>(s.request->stride[d]);
+    }
+
+    // Copy the elements of a piece from the bounding box to the output.
+    static void copy(const piece& s, const index_type& lower, const index_type& bcount, const T *buffer)
+    {
+        const typed_planned_read& r = *s.request;
+        const std::size_t ndims = bcount.size();
+        if (ndims == 0) {
+            r.out[0] = buffer[0];
+            return;
+        }
+
+        const std::size_t n = s.count[ndims-1];
+        const std::size_t step = static_cast<std::size_t>(r.stride[ndims-1]);
+        index_type k(ndims - 1, 0);
+        for (;;) {
+            std::size_t src = 0, dst = 0;
+            for (std::size_t d = 0; d < ndims; ++d) {
+                const std::size_t j = (d + 1 < ndims) ? k[d] : 0;
+                src = src * bcount[d] + (element(s, d, j) - lower[d]);
+                dst = dst * r.count[d] + s.position[d] + j;
+            }
+            for (std::size_t i = 0; i < n; ++i)
+                r.out[dst + i] = buffer[src + i * step];
+
+            std::size_t d = ndims - 1;
+            for (; d != 0; --d) {
+                if (++k[d-1] < s.count[d-1])
+                    break;
+                k[d-1] = 0;
+            }
+            if (d == 0)
+                break;
+        }
+    }
+
+    T *out;
+};
+
+} // namespace detail
+
+/// Batch of reads that are executed together in chunk order. Requests on
+/// the same variable are split at chunk boundaries, and each chunk touched
+/// by any request is read once, so overlapping requests do not decompress
+/// the same chunk again. Each result is copied to the memory of its request.
+class access_planner
+{
+public:
+    /// Add a read of a variable selection to allocated memory with capacity
+    /// for var.size() elements. The memory must remain valid until execute().
+    template <class T>
+    void add(const variable& var, T *out)
+    {
+        add(var, var.start(), var.shape(), var.stride(), out);
+    }
+
+    /// Add a read of a strided hyperslab of a variable to allocated memory.
+    /// Indexes are relative to the variable in the file.
+    template <class T>
+    void add(const variable& var, const index_type& start, const index_type& count,
+             const stride_type& stride, T *out)
+    {
+        const std::size_t ndims = var.shape().size();
+        if (start.size() != ndims || count.size() != ndims || stride.size() != ndims)
+            detail::throw_error(error::invalid_argument);
+        if (std::any_of(stride.begin(), stride.end(), [](std::ptrdiff_t s) { return s < 1; }))
+            detail::throw_error(error::illegal_stride);
+
+        requests_.push_back(std::make_unique<detail::typed_planned_read<T>>(
+            var.ncid(), var.varid(), start, count, stride, out));
+    }
+
+    /// Get the number of pending requests.
+    std::size_t size() const noexcept {
+        return requests_.size();
+    }
+
+    /// Returns true if there are no pending requests.
+    bool empty() const noexcept {
+        return requests_.empty();
+    }
+
+    /// Discard pending requests.
+    void clear() noexcept {
+        requests_.clear();
+    }
+
+    /// Execute and remove all pending requests. Requests are grouped by
+    /// variable and type, and the groups are read in order of variable.
+    void execute()
+    {
+        std::vector<detail::planned_read *> order;
+        order.reserve(requests_.size());
+        for (const auto& r : requests_)
+            order.push_back(r.get());
+
+        auto key = [](const detail::planned_read *r) { return std::make_tuple(r->ncid, r->varid, r->type); };
+        std::stable_sort(order.begin(), order.end(),
+            [&](const detail::planned_read *a, const detail::planned_read *b) { return key(a) < key(b); });
+
+        auto requests = std::move(requests_);
+        requests_.clear();
+
+        std::vector<detail::planned_read *> group;
+        for (auto first = order.begin(); first != order.end(); /**/) {
+            auto last = std::find_if(first, order.end(),
+                [&](const detail::planned_read *r) { return key(r) != key(*first); });
+            group.assign(first, last);
+            (*first)->execute(group);
+            first = last;
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<detail::planned_read>> requests_;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_ACCESS_PLANNER_HPP
@@ -17,6 +17,7 @@
 
 #include <ncpp/functions/variable.hpp>
 #include <ncpp/functions/attribute.hpp>
+#include <ncpp/metadata.hpp>
 #include <ncpp/check.hpp>
 #include <ncpp/types.hpp>
 #include <ncpp/variant.hpp>
@@ -25,31 +26,42 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace ncpp {
 
 class attributes_type;
 
-/// netCDF attribute type.
+/// netCDF attribute type. Lightweight view on the dataset metadata.
 class attribute
 {
     friend class attributes_type;
 
 public:
+    attribute(std::shared_ptr<const metadata> meta, int varid, std::string_view attname)
+        : meta_(std::move(meta)), varid_(varid), info_(meta_->find_att(varid, attname))
+    {
+        if (info_ == nullptr)
+            detail::throw_error(error::attribute_not_found);
+    }
+
+    /// Construct a view on a new metadata snapshot of the dataset. Only the
+    /// dimensions and variable IDs are read up front; use the constructor
+    /// taking a shared snapshot for several views of one dataset.
     attribute(int ncid, int varid, const std::string& attname)
-        : ncid_(ncid), varid_(varid), attname_(attname) {}
+        : attribute(std::make_shared<const metadata>(ncid), varid, attname) {}
 
     bool operator<(const attribute& rhs) const {
-        return std::tie(varid_, attname_) <
-               std::tie(rhs.varid_, rhs.attname_);
+        return std::tie(varid_, name()) <
+               std::tie(rhs.varid_, rhs.name());
     }
     
     bool operator==(const attribute& rhs) const {
-        return std::tie(ncid_, varid_, attname_) ==
-               std::tie(rhs.ncid_, rhs.varid_, rhs.attname_);
+        return ncid() == rhs.ncid() && varid_ == rhs.varid_ && name() == rhs.name();
     }
 
     bool operator!=(const attribute& rhs) const {
@@ -57,14 +69,14 @@ public:
     }
 
     /// Get the attribute name.
-    std::string name() const
+    const std::string& name() const
     {
-        return attname_;
+        return info_->name;
     }
 
     /// Get the netCDF ID.
     int ncid() const {
-        return ncid_;
+        return meta_->ncid();
     }
 
     /// Get the associated variable ID, or NC_GLOBAL for global attributes.
@@ -75,41 +87,41 @@ public:
     /// Get the attribute length.
     std::size_t length() const
     {
-        return api::inq_attlen(ncid_, varid_, attname_);
+        return info_->length;
     }
 
     /// Get the netCDF type ID for the attribute.
     int netcdf_type() const
     {
-        return api::inq_atttype(ncid_, varid_, attname_);
+        return info_->type;
     }
     
     /// Get scalar attribute with arithmetic type.
     template <class T>
     typename std::enable_if<std::is_arithmetic<T>::value, T>::type value() const
     {
-        return api::get_att<T>(ncid_, varid_, attname_);
+        return api::get_att<T>(ncid(), varid_, name());
     }
 
     /// Get scalar attribute with fixed-length string type (`NC_CHAR`).
     template <class T>
     typename std::enable_if<std::is_same<T, std::string>::value, std::string>::type value() const
     {
-        return api::get_att<T>(ncid_, varid_, attname_);
+        return api::get_att<T>(ncid(), varid_, name());
     }
 
     /// Get attribute array with arithmetic type.
     template <class T, class A = std::allocator<T>>
     typename std::enable_if<std::is_arithmetic<T>::value, std::vector<T, A>>::type values() const
     {
-        return api::get_att_array<std::vector<T, A>>(ncid_, varid_, attname_);
+        return api::get_att_array<std::vector<T, A>>(ncid(), varid_, name());
     }
 
     /// Get attribute array with variable-length string type (`NC_STRING`).
     template <class T, class A = std::allocator<T>>
     typename std::enable_if<std::is_same<T, std::string>::value, std::vector<std::string, A>>::type values() const
     {
-        return api::get_att_array<std::vector<T, A>>(ncid_, varid_, attname_);
+        return api::get_att_array<std::vector<T, A>>(ncid(), varid_, name());
     }
 
     /// Get attribute array with variant type.
@@ -134,10 +146,13 @@ public:
         }
     }
 
-private:    
-    int ncid_;
+private:
+    attribute(std::shared_ptr<const metadata> meta, int varid, const metadata::attribute_info *info)
+        : meta_(std::move(meta)), varid_(varid), info_(info) {}
+
+    std::shared_ptr<const metadata> meta_;
     int varid_;
-    std::string attname_;
+    const metadata::attribute_info *info_;
 };
 
 } // namespace ncpp
@@ -15,105 +15,102 @@
 
 #include <ncpp/config.hpp>
 
-#include <ncpp/functions/variable.hpp>
-#include <ncpp/functions/attribute.hpp>
+#include <ncpp/detail/view_iterator.hpp>
 #include <ncpp/attribute.hpp>
+#include <ncpp/metadata.hpp>
 #include <ncpp/check.hpp>
 
-#include <set>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 
 namespace ncpp {
 
 class dataset;
 class variable;
 
-/// netCDF attribute set.
+/// netCDF attribute sequence container, in attribute number order.
 class attributes_type
 {
     friend class dataset;
     friend class variable;
+    friend class detail::view_iterator<attributes_type>;
 
 public:
-    using storage_type = std::set<attribute>;
-    using value_type = typename storage_type::value_type;
-    using iterator = storage_type::iterator;
-    using const_iterator = storage_type::const_iterator;
-    using reference = storage_type::reference;
-    using const_reference = storage_type::const_reference;
-
-    attributes_type(int ncid, int varid = NC_GLOBAL)
-        : ncid_(ncid), varid_(varid)
-    {
-        int natts = api::inq_varnatts(ncid, varid);
-        for (int attnum = 0; attnum < natts; ++attnum) {
-            std::string attname = api::inq_attname(ncid, varid, attnum);
-            atts_.emplace(attribute(ncid, varid, attname));
-        }
-    }
+    using value_type = attribute;
+    using iterator = detail::view_iterator<attributes_type>;
+    using const_iterator = iterator;
+    using reference = value_type;
+    using const_reference = value_type;
+
+    /// Attributes are loaded on first access.
+    explicit attributes_type(std::shared_ptr<const metadata> meta, int varid = NC_GLOBAL)
+        : meta_(std::move(meta)), varid_(varid)
+    {}
     
-    iterator begin() noexcept {
-        return atts_.begin();
-    }
-
-    iterator end() noexcept {
-        return atts_.end();
-    }
-
-    const_iterator begin() const noexcept {
-        return atts_.begin();
+    const_iterator begin() const {
+        return const_iterator(this, 0);
     }
 
-    const_iterator end() const noexcept {
-        return atts_.end();
+    const_iterator end() const {
+        return const_iterator(this, size());
     }
     
     const_reference front() const {
-        return *atts_.cbegin();
+        return get(0);
     }
 
     const_reference back() const {
-        return *atts_.cend();
+        return get(size() - 1);
     }
 
-    std::size_t size() const noexcept {
-        return atts_.size();
+    std::size_t size() const {
+        return meta_->atts(varid_).size();
     }
 
-    bool empty() const noexcept {
-        return atts_.empty();
+    bool empty() const {
+        return size() == 0;
     }
 
     /// Get an attribute by name.
-    const_reference operator[](const std::string& name) const
+    const_reference operator[](std::string_view name) const
     {
-        const auto it = atts_.find(attribute(ncid_, varid_, name));
-        if (it == atts_.end())
+        const auto *info = meta_->find_att(varid_, name);
+        if (info == nullptr)
             detail::throw_error(error::attribute_not_found);
 
-        return *it;
+        return attribute(meta_, varid_, info);
     }
 
     /// Get an attribute by index.
     const_reference at(std::size_t n) const
     {
-        if (n >= atts_.size())
+        if (n >= size())
             detail::throw_error(error::attribute_not_found);
 
-        return *std::next(atts_.begin(), n);
+        return get(n);
     }
 
     /// Determine if an attribute is present.
-    bool contains(const std::string& name) const noexcept
+    bool contains(std::string_view name) const noexcept
     {
-        const auto it = std::find(atts_.begin(), atts_.end(), attribute(ncid_, varid_, name));
-        return (it != atts_.end());
+        try {
+            return meta_->find_att(varid_, name) != nullptr;
+        }
+        catch (...) {
+            return false;
+        }
     }
 
 private:
-    int ncid_;
+    value_type get(std::size_t n) const
+    {
+        return attribute(meta_, varid_, &meta_->atts(varid_)[n]);
+    }
+
+    std::shared_ptr<const metadata> meta_;
     int varid_;
-    storage_type atts_;
 };
 
 } // namespace ncpp
@@ -0,0 +1,163 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_BLOCK_READER_HPP
+#define NCPP_BLOCK_READER_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/detail/netcdf_lock.hpp>
+#include <ncpp/iterator.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+
+/// Block of values read by a block reader.
+template <class T, class A = std::allocator<T>>
+struct block
+{
+    /// Number of elements preceding the block in iteration order.
+    std::size_t offset = 0;
+
+    /// Start index for the block.
+    index_type start;
+
+    /// Position of the block within the selection.
+    index_type position;
+
+    /// Counts (edge lengths) for the block.
+    index_type count;
+
+    /// Block values.
+    std::vector<T, A> data;
+};
+
+/// Pipelined block reader. A dedicated I/O thread advances the iterator and
+/// reads up to `depth` blocks ahead of the consumer into a pool of reusable
+/// buffers. netCDF-C is not thread-safe; the I/O thread reads while holding
+/// detail::netcdf_lock, so other threads must hold the lock to call netCDF-C
+/// until the reader is destroyed.
+template <class T, class Iterator = block_iterator, class A = std::allocator<T>>
+class block_reader
+{
+public:
+    using block_type = block<T, A>;
+
+    explicit block_reader(Iterator it, std::size_t depth = NCPP_DEFAULT_PREFETCH_DEPTH)
+        : it_(std::move(it)), pool_(std::max<std::size_t>(depth, 1) + 1), thread_([this] { run(); })
+    {}
+
+    block_reader(const block_reader&) = delete;
+    block_reader& operator=(const block_reader&) = delete;
+
+    ~block_reader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        free_cv_.notify_all();
+        thread_.join();
+    }
+
+    /// Get the next block. The previous contents of `b` are returned to the
+    /// buffer pool. Returns false when past the end, and rethrows any error
+    /// raised on the I/O thread.
+    bool next(block_type& b)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (b.data.capacity() > 0) {
+            pool_.emplace_back(std::exchange(b, block_type{}));
+            free_cv_.notify_one();
+        }
+
+        ready_cv_.wait(lock, [this] { return done_ || !ready_.empty(); });
+        if (!ready_.empty()) {
+            b = std::move(ready_.front());
+            ready_.pop_front();
+            return true;
+        }
+
+        if (error_)
+            std::rethrow_exception(std::exchange(error_, nullptr));
+
+        return false;
+    }
+
+private:
+    // I/O thread: read each block into a free buffer and queue it.
+    void run()
+    {
+        try {
+            while (it_.next()) {
+                block_type b;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    free_cv_.wait(lock, [this] { return stopped_ || !pool_.empty(); });
+                    if (stopped_)
+                        break;
+                    b = std::move(pool_.back());
+                    pool_.pop_back();
+                }
+
+                b.offset = it_.offset() - it_.block_size();
+                b.start = it_.start();
+                b.position = it_.position();
+                b.count = it_.count();
+                {
+                    detail::netcdf_lock lock;
+                    it_.read(b.data);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ready_.emplace_back(std::move(b));
+                }
+                ready_cv_.notify_one();
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        ready_cv_.notify_all();
+    }
+
+    Iterator it_;
+    std::mutex mutex_;
+    std::condition_variable free_cv_;
+    std::condition_variable ready_cv_;
+    std::vector<block_type> pool_;
+    std::deque<block_type> ready_;
+    std::exception_ptr error_;
+    bool stopped_ = false;
+    bool done_ = false;
+    std::thread thread_;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_BLOCK_READER_HPP
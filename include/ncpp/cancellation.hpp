@@ -0,0 +1,55 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_CANCELLATION_HPP
+#define NCPP_CANCELLATION_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <atomic>
+#include <memory>
+#include <system_error>
+
+namespace ncpp {
+
+/// Cancellation flag shared by copies, passed to asynchronous requests.
+/// Requests that have not started when cancelled complete with
+/// std::errc::operation_canceled.
+class cancellation
+{
+public:
+    cancellation()
+        : flag_(std::make_shared<std::atomic<bool>>(false))
+    {}
+
+    /// Request cancellation.
+    void cancel() noexcept {
+        flag_->store(true, std::memory_order_relaxed);
+    }
+
+    /// Returns true if cancellation was requested.
+    bool is_cancelled() const noexcept {
+        return flag_->load(std::memory_order_relaxed);
+    }
+
+    /// Throw std::errc::operation_canceled if cancellation was requested.
+    void throw_if_cancelled() const
+    {
+        if (is_cancelled())
+            throw std::system_error(std::make_error_code(std::errc::operation_canceled));
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_CANCELLATION_HPP
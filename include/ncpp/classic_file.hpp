@@ -0,0 +1,508 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_CLASSIC_FILE_HPP
+#define NCPP_CLASSIC_FILE_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <netcdf.h>
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/detail/kernels.hpp>
+#include <ncpp/detail/memory_map.hpp>
+#include <ncpp/functions/ndarray.hpp>
+#include <ncpp/variable.hpp>
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ncpp {
+
+/// Read-only view of big-endian values in memory. Values are converted to
+/// native byte order on access.
+template <class T>
+class big_endian_view
+{
+public:
+    big_endian_view(const unsigned char *data, std::size_t size)
+        : data_(data), size_(size)
+    {}
+
+    /// Get a pointer to the raw bytes.
+    const unsigned char *data() const noexcept {
+        return data_;
+    }
+
+    /// Get the number of values.
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    /// Get a value by position.
+    T operator[](std::size_t i) const noexcept {
+        return detail::load_big_endian<T>(data_ + i * sizeof(T));
+    }
+
+    /// Copy all values to allocated memory in native byte order.
+    void read(T *out) const noexcept {
+        detail::load_big_endian(data_, size_, out);
+    }
+
+    /// Get values as std::vector.
+    template <class A = std::allocator<T>>
+    std::vector<T, A> values() const
+    {
+        std::vector<T, A> result(size_);
+        read(result.data());
+        return result;
+    }
+
+private:
+    const unsigned char *data_;
+    std::size_t size_;
+};
+
+/// Native reader for classic format (CDF-1, CDF-2 and CDF-5) files. The
+/// header is parsed once, and data is read directly from memory without
+/// calling netCDF-C, so a classic_file may be read from many threads at
+/// once. Values are not converted between types: T must have the size and
+/// representation of the external type of a variable.
+class classic_file
+{
+public:
+    struct dimension_info
+    {
+        std::string name;
+        std::size_t length;     // current number of records for the record dimension
+        bool is_record;
+    };
+
+    struct variable_info
+    {
+        std::string name;
+        int type;
+        std::vector<std::size_t> dimids;
+        index_type shape;
+        std::uint64_t begin;    // offset of the data, or of the first record
+        std::uint64_t vsize;    // size of the data, or of one record, in bytes
+        bool is_record;
+    };
+
+    /// Parse a file in memory. The buffer must remain valid for the lifetime
+    /// of the object.
+    classic_file(const void *data, std::size_t size)
+        : data_(static_cast<const unsigned char *>(data)), size_(size)
+    {
+        parse();
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+
+    /// Map a file read-only and parse it.
+    explicit classic_file(const std::filesystem::path& path)
+    {
+        auto mapping = detail::map_file(path);
+        mapping_ = std::move(mapping.data);
+        data_ = static_cast<const unsigned char *>(mapping_.get());
+        size_ = mapping.size;
+        parse();
+    }
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+    /// Get the format version (1, 2 or 5).
+    int version() const noexcept {
+        return version_;
+    }
+
+    /// Get the number of records.
+    std::size_t numrecs() const noexcept {
+        return numrecs_;
+    }
+
+    /// Get the size of one record of all record variables in bytes.
+    std::uint64_t record_size() const noexcept {
+        return recsize_;
+    }
+
+    /// Get the dimensions in order of definition.
+    const std::vector<dimension_info>& dimensions() const noexcept {
+        return dims_;
+    }
+
+    /// Get the variables in order of definition.
+    const std::vector<variable_info>& variables() const noexcept {
+        return vars_;
+    }
+
+    /// Get a variable by name.
+    const variable_info& at(const std::string& name) const
+    {
+        auto it = std::find_if(vars_.begin(), vars_.end(),
+            [&](const variable_info& v) { return v.name == name; });
+        if (it == vars_.end())
+            detail::throw_error(error::variable_not_found);
+
+        return *it;
+    }
+
+    /// Get a view of all values of a variable. Record variables are
+    /// contiguous only if there are no other record variables.
+    template <class T>
+    big_endian_view<T> view(const std::string& name) const
+    {
+        const auto& v = at(name);
+        check_type<T>(v);
+        if (v.is_record && nrecvars_ != 1)
+            detail::throw_error(error::invalid_argument);
+        return make_view<T>(v.begin, api::compute_size(v.shape));
+    }
+
+    /// Get a view of one record of a record variable.
+    template <class T>
+    big_endian_view<T> view(const std::string& name, std::size_t record) const
+    {
+        const auto& v = at(name);
+        check_type<T>(v);
+        if (!v.is_record)
+            detail::throw_error(error::invalid_argument);
+        if (record >= numrecs_)
+            detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+        return make_view<T>(v.begin + record * recsize_, api::compute_size(v.shape) / numrecs_);
+    }
+
+    /// Copy a strided hyperslab of a variable to allocated memory in native
+    /// byte order. Contiguous rows are converted in bulk.
+    template <class T>
+    void read(const std::string& name, const index_type& start, const index_type& count,
+              const stride_type& stride, T *out) const
+    {
+        const auto& v = at(name);
+        check_type<T>(v);
+
+        const std::size_t ndims = v.shape.size();
+        if (start.size() != ndims || count.size() != ndims || stride.size() != ndims)
+            detail::throw_error(error::invalid_argument);
+
+        for (std::size_t d = 0; d < ndims; ++d) {
+            if (stride[d] < 1)
+                detail::throw_error(error::illegal_stride);
+            if (start[d] > v.shape[d])
+                detail::throw_error(error::invalid_coordinates);
+            if (count[d] > 0 && start[d] + (count[d] - 1) * static_cast<std::size_t>(stride[d]) >= v.shape[d])
+                detail::throw_error(error::argument_out_of_domain);
+        }
+
+        if (api::compute_size(count) == 0)
+            return;
+
+        // Byte steps along each dimension. The record dimension steps over
+        // one record of all record variables.
+        std::vector<std::uint64_t> step(ndims);
+        std::uint64_t s = sizeof(T);
+        for (std::size_t d = ndims; d-- > 0; ) {
+            if (d == 0 && v.is_record)
+                step[d] = recsize_;
+            else {
+                step[d] = s;
+                s *= v.shape[d];
+            }
+        }
+
+        std::uint64_t first = v.begin, last = v.begin;
+        for (std::size_t d = 0; d < ndims; ++d) {
+            first += start[d] * step[d];
+            last += (start[d] + (count[d] - 1) * static_cast<std::size_t>(stride[d])) * step[d];
+        }
+        if (last + sizeof(T) > size_)
+            detail::throw_error(error::file_truncated);
+
+        if (ndims == 0) {
+            *out = detail::load_big_endian<T>(data_ + first);
+            return;
+        }
+
+        // Convert one row along the last dimension at a time.
+        const std::size_t n = count[ndims-1];
+        const std::uint64_t inner = step[ndims-1] * static_cast<std::uint64_t>(stride[ndims-1]);
+        index_type k(ndims - 1, 0);
+        for (;;) {
+            std::uint64_t offset = first;
+            for (std::size_t d = 0; d + 1 < ndims; ++d)
+                offset += k[d] * static_cast<std::uint64_t>(stride[d]) * step[d];
+
+            if (inner == sizeof(T))
+                detail::load_big_endian(data_ + offset, n, out);
+            else {
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = detail::load_big_endian<T>(data_ + offset + i * inner);
+            }
+            out += n;
+
+            std::size_t d = ndims - 1;
+            for (; d != 0; --d) {
+                if (++k[d-1] < count[d-1])
+                    break;
+                k[d-1] = 0;
+            }
+            if (d == 0)
+                break;
+        }
+    }
+
+    /// Copy a hyperslab of a variable to allocated memory in native byte order.
+    template <class T>
+    void read(const std::string& name, const index_type& start, const index_type& count, T *out) const
+    {
+        read(name, start, count, stride_type(start.size(), 1), out);
+    }
+
+    /// Copy the values of a variable selection to allocated memory in native
+    /// byte order. The selection must be from a dataset opened on the same file.
+    template <class T>
+    void read(const variable& var, T *out) const
+    {
+        read(var.name(), var.start(), var.shape(), var.stride(), out);
+    }
+
+    /// Get the values of a variable selection as std::vector.
+    template <class T, class A = std::allocator<T>>
+    std::vector<T, A> values(const variable& var) const
+    {
+        std::vector<T, A> result(var.size());
+        read(var, result.data());
+        return result;
+    }
+
+private:
+    // Sequential reader over the header.
+    struct cursor
+    {
+        const unsigned char *p;
+        const unsigned char *end;
+        int version;
+
+        void need(std::uint64_t n) const {
+            if (static_cast<std::uint64_t>(end - p) < n)
+                detail::throw_error(error::not_a_netcdf_file);
+        }
+
+        std::uint64_t u32() {
+            need(4);
+            auto x = detail::load_big_endian<std::uint32_t>(p);
+            p += 4;
+            return x;
+        }
+
+        std::uint64_t u64() {
+            need(8);
+            auto x = detail::load_big_endian<std::uint64_t>(p);
+            p += 8;
+            return x;
+        }
+
+        std::uint64_t non_neg() {
+            return (version == 5) ? u64() : u32();
+        }
+
+        std::uint64_t offset() {
+            return (version == 1) ? u32() : u64();
+        }
+
+        void skip(std::uint64_t n) {
+            need(n);
+            p += n;
+        }
+
+        std::string name() {
+            const std::uint64_t n = non_neg();
+            need(n);
+            std::string s(reinterpret_cast<const char *>(p), static_cast<std::size_t>(n));
+            skip(padded(n));
+            return s;
+        }
+    };
+
+    static constexpr std::uint32_t tag_dimension = 0x0A;
+    static constexpr std::uint32_t tag_variable = 0x0B;
+    static constexpr std::uint32_t tag_attribute = 0x0C;
+
+    static std::uint64_t padded(std::uint64_t n) noexcept {
+        return (n + 3) & ~std::uint64_t(3);
+    }
+
+    static std::size_t type_size(int type) noexcept
+    {
+        switch (type) {
+        case NC_BYTE: case NC_CHAR: case NC_UBYTE: return 1;
+        case NC_SHORT: case NC_USHORT: return 2;
+        case NC_INT: case NC_FLOAT: case NC_UINT: return 4;
+        case NC_DOUBLE: case NC_INT64: case NC_UINT64: return 8;
+        default: return 0;
+        }
+    }
+
+    template <class T>
+    static void check_type(const variable_info& v)
+    {
+        static_assert(std::is_arithmetic<T>::value, "T must be an arithmetic type");
+        if (type_size(v.type) != sizeof(T) ||
+            std::is_floating_point<T>::value != (v.type == NC_FLOAT || v.type == NC_DOUBLE))
+            detail::throw_error(error::invalid_data_type);
+    }
+
+    template <class T>
+    big_endian_view<T> make_view(std::uint64_t offset, std::size_t n) const
+    {
+        if (offset > size_ || n > (size_ - offset) / sizeof(T))
+            detail::throw_error(error::file_truncated);
+        return big_endian_view<T>(data_ + offset, n);
+    }
+
+    // Get the number of elements in a list, or zero if the list is absent.
+    static std::uint64_t list_size(cursor& c, std::uint32_t tag)
+    {
+        const std::uint64_t t = c.u32();
+        const std::uint64_t n = c.non_neg();
+        if (t != tag && (t != 0 || n != 0))
+            detail::throw_error(error::not_a_netcdf_file);
+        return n;
+    }
+
+    static void skip_attributes(cursor& c)
+    {
+        const std::uint64_t natts = list_size(c, tag_attribute);
+        for (std::uint64_t i = 0; i < natts; ++i) {
+            c.name();
+            const std::size_t size = type_size(static_cast<int>(c.u32()));
+            const std::uint64_t nelems = c.non_neg();
+            if (size == 0)
+                detail::throw_error(error::invalid_data_type);
+            c.need(nelems);
+            c.skip(padded(nelems * size));
+        }
+    }
+
+    void parse()
+    {
+        cursor c{ data_, data_ + size_, 0 };
+        c.need(4);
+        if (c.p[0] != 'C' || c.p[1] != 'D' || c.p[2] != 'F' || (c.p[3] != 1 && c.p[3] != 2 && c.p[3] != 5))
+            detail::throw_error(error::not_a_netcdf_file);
+        version_ = c.p[3];
+        c.version = version_;
+        c.skip(4);
+
+        const std::uint64_t numrecs = c.non_neg();
+        const bool streaming = (version_ == 5) ? (numrecs == ~std::uint64_t(0)) : (numrecs == 0xFFFFFFFFu);
+
+        const std::uint64_t ndims = list_size(c, tag_dimension);
+        for (std::uint64_t i = 0; i < ndims; ++i) {
+            dimension_info dim;
+            dim.name = c.name();
+            dim.length = static_cast<std::size_t>(c.non_neg());
+            dim.is_record = (dim.length == 0);
+            dims_.push_back(std::move(dim));
+        }
+
+        skip_attributes(c);
+
+        const std::uint64_t nvars = list_size(c, tag_variable);
+        for (std::uint64_t i = 0; i < nvars; ++i) {
+            variable_info v;
+            v.name = c.name();
+            const std::uint64_t rank = c.non_neg();
+            c.need(rank);
+            for (std::uint64_t d = 0; d < rank; ++d) {
+                const std::uint64_t dimid = c.non_neg();
+                if (dimid >= dims_.size())
+                    detail::throw_error(error::invalid_dimension);
+                if (dims_[dimid].is_record && d != 0)
+                    detail::throw_error(error::bad_unlimited_index);
+                v.dimids.push_back(static_cast<std::size_t>(dimid));
+                v.shape.push_back(dims_[dimid].length);
+            }
+            skip_attributes(c);
+            v.type = static_cast<int>(c.u32());
+            if (type_size(v.type) == 0)
+                detail::throw_error(error::invalid_data_type);
+            c.non_neg(); // vsize, which may be truncated for large variables
+            v.begin = c.offset();
+            v.is_record = !v.dimids.empty() && dims_[v.dimids[0]].is_record;
+
+            // Size of the data, or of one record, rounded up to four bytes.
+            std::uint64_t n = type_size(v.type);
+            for (std::size_t d = v.is_record ? 1 : 0; d < v.shape.size(); ++d)
+                n *= v.shape[d];
+            v.vsize = padded(n);
+            vars_.push_back(std::move(v));
+        }
+
+        // Records of a single record variable are not padded.
+        std::uint64_t first_record = size_;
+        recsize_ = 0;
+        nrecvars_ = 0;
+        for (const auto& v : vars_) {
+            if (v.is_record) {
+                recsize_ += v.vsize;
+                first_record = std::min(first_record, v.begin);
+                ++nrecvars_;
+            }
+        }
+        if (nrecvars_ == 1) {
+            for (const auto& v : vars_) {
+                if (v.is_record) {
+                    recsize_ = type_size(v.type);
+                    for (std::size_t d = 1; d < v.shape.size(); ++d)
+                        recsize_ *= v.shape[d];
+                }
+            }
+        }
+
+        // The number of records of a streamed file is not known until it is
+        // closed, so infer it from the size of the file.
+        if (streaming)
+            numrecs_ = (recsize_ > 0 && first_record < size_) ? static_cast<std::size_t>((size_ - first_record) / recsize_) : 0;
+        else
+            numrecs_ = static_cast<std::size_t>(numrecs);
+
+        for (auto& dim : dims_) {
+            if (dim.is_record)
+                dim.length = numrecs_;
+        }
+        for (auto& v : vars_) {
+            if (v.is_record)
+                v.shape[0] = numrecs_;
+        }
+    }
+
+    std::shared_ptr<const void> mapping_;
+    const unsigned char *data_;
+    std::size_t size_;
+    int version_ = 0;
+    std::size_t numrecs_ = 0;
+    std::uint64_t recsize_ = 0;
+    std::size_t nrecvars_ = 0;
+    std::vector<dimension_info> dims_;
+    std::vector<variable_info> vars_;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_CLASSIC_FILE_HPP
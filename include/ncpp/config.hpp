@@ -17,7 +17,25 @@
 #define NCPP_DEFAULT_BUFFER_SIZE 5000000
 #endif
 
+// Default number of blocks read ahead by the block reader.
+#ifndef NCPP_DEFAULT_PREFETCH_DEPTH
+#define NCPP_DEFAULT_PREFETCH_DEPTH 2
+#endif
+
+// Default number of open files kept by a multi-file dataset.
+#ifndef NCPP_DEFAULT_MAX_OPEN_FILES
+#define NCPP_DEFAULT_MAX_OPEN_FILES 16
+#endif
+
+// Upper limit for chunk cache sizes chosen by variable::tune_chunk_cache()
+// in bytes.
+#ifndef NCPP_MAX_CHUNK_CACHE_SIZE
+#define NCPP_MAX_CHUNK_CACHE_SIZE 1073741824
+#endif
+
 //#define NCPP_USE_BOOST
 //#define NCPP_USE_DATE_H
+//#define NCPP_USE_HDF5
+//#define NCPP_USE_ZSTD
 
 #endif // NCPP_CONFIG_HPP
\ No newline at end of file
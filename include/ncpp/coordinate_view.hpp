@@ -0,0 +1,191 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_COORDINATE_VIEW_HPP
+#define NCPP_COORDINATE_VIEW_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+
+/// Lazy view of the cartesian product of coordinate vectors in row-major
+/// order, matching the order of the variable values. Only the coordinate
+/// vectors are stored; tuples are computed on access.
+template <class... Ts>
+class coordinate_view
+{
+    static constexpr std::size_t N = sizeof...(Ts);
+    using index_array = std::array<std::size_t, N>;
+
+public:
+    using value_type = std::tuple<Ts...>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using columns_type = std::tuple<std::vector<Ts>...>;
+
+    /// Random access iterator. Sequential iteration steps the index of each
+    /// dimension without division.
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename coordinate_view::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+
+        struct pointer {
+            value_type value;
+            const value_type *operator->() const { return &value; }
+        };
+
+        const_iterator() = default;
+
+        const_iterator(const coordinate_view *view, std::size_t n)
+            : view_(view), n_(n), index_(view->unravel(n)) {}
+
+        reference operator*() const { return view_->get(index_, std::index_sequence_for<Ts...>{}); }
+        pointer operator->() const { return pointer{ **this }; }
+        reference operator[](difference_type k) const { return (*view_)[n_ + k]; }
+
+        const_iterator& operator++()
+        {
+            ++n_;
+            for (std::size_t i = N; i != 0; --i) {
+                if (++index_[i-1] < view_->shape_[i-1] || i == 1)
+                    break;
+                index_[i-1] = 0;
+            }
+            return *this;
+        }
+
+        const_iterator& operator--() { return *this -= 1; }
+        const_iterator operator++(int) { auto it = *this; ++*this; return it; }
+        const_iterator operator--(int) { auto it = *this; --*this; return it; }
+
+        const_iterator& operator+=(difference_type k) { n_ += k; index_ = view_->unravel(n_); return *this; }
+        const_iterator& operator-=(difference_type k) { n_ -= k; index_ = view_->unravel(n_); return *this; }
+        const_iterator operator+(difference_type k) const { return const_iterator(view_, n_ + k); }
+        const_iterator operator-(difference_type k) const { return const_iterator(view_, n_ - k); }
+        friend const_iterator operator+(difference_type k, const const_iterator& it) { return it + k; }
+
+        difference_type operator-(const const_iterator& rhs) const {
+            return static_cast<difference_type>(n_) - static_cast<difference_type>(rhs.n_);
+        }
+
+        bool operator==(const const_iterator& rhs) const { return view_ == rhs.view_ && n_ == rhs.n_; }
+        bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+        bool operator<(const const_iterator& rhs) const { return n_ < rhs.n_; }
+        bool operator>(const const_iterator& rhs) const { return n_ > rhs.n_; }
+        bool operator<=(const const_iterator& rhs) const { return n_ <= rhs.n_; }
+        bool operator>=(const const_iterator& rhs) const { return n_ >= rhs.n_; }
+
+    private:
+        const coordinate_view *view_ = nullptr;
+        std::size_t n_ = 0;
+        index_array index_ = {};
+    };
+
+    using iterator = const_iterator;
+
+    explicit coordinate_view(columns_type columns)
+        : columns_(std::move(columns))
+    {
+        init_shape(std::index_sequence_for<Ts...>{});
+        size_ = 1;
+        for (const auto& len : shape_)
+            size_ *= len;
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size_);
+    }
+
+    size_type size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    /// Get the coordinates at a linear offset.
+    value_type operator[](size_type n) const {
+        return get(unravel(n), std::index_sequence_for<Ts...>{});
+    }
+
+    /// Get the coordinates at a linear offset, with bounds checking.
+    value_type at(size_type n) const
+    {
+        if (n >= size_)
+            detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+        return (*this)[n];
+    }
+
+    /// Get the coordinate vector for one dimension.
+    template <std::size_t I>
+    const auto& column() const noexcept {
+        return std::get<I>(columns_);
+    }
+
+    /// Get the number of coordinates for each dimension.
+    const index_array& shape() const noexcept {
+        return shape_;
+    }
+
+private:
+    template <std::size_t... Is>
+    void init_shape(std::index_sequence<Is...>) {
+        shape_ = index_array{ std::get<Is>(columns_).size()... };
+    }
+
+    template <std::size_t... Is>
+    value_type get(const index_array& index, std::index_sequence<Is...>) const {
+        return value_type(std::get<Is>(columns_)[index[Is]]...);
+    }
+
+    // Create an index array from a linear offset.
+    index_array unravel(std::size_t n) const
+    {
+        index_array index = {};
+        if (n >= size_) {
+            // Past the end: first index out of range, others zero.
+            if (N > 0)
+                index[0] = (N == 1 || size_ == 0) ? n : shape_[0];
+            return index;
+        }
+        for (std::size_t i = N; i != 0; --i) {
+            index[i-1] = n % shape_[i-1];
+            n /= shape_[i-1];
+        }
+        return index;
+    }
+
+    columns_type columns_;
+    index_array shape_ = {};
+    std::size_t size_ = 0;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_COORDINATE_VIEW_HPP
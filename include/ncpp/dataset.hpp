@@ -20,8 +20,12 @@
 #include <ncpp/dimensions.hpp>
 #include <ncpp/variables.hpp>
 #include <ncpp/attributes.hpp>
+#include <ncpp/metadata.hpp>
 #include <ncpp/check.hpp>
 
+#include <memory>
+#include <utility>
+
 namespace ncpp {
 
 /// netCDF dataset type.
@@ -29,7 +33,11 @@ class dataset
 {
 public:
     explicit dataset(const file& file)
-        : dims(file.ncid_), vars(file.ncid_), atts(file.ncid_), ncid_(file.ncid_)
+        : dataset(std::make_shared<const metadata>(file.ncid_))
+    {}
+
+    explicit dataset(std::shared_ptr<const metadata> meta)
+        : dims(meta), vars(meta), atts(meta), meta_(std::move(meta))
     {}
 
     /// Dimensions associated with the netCDF dataset.
@@ -41,8 +49,13 @@ public:
     /// Global attributes associated with the netCDF dataset.
     attributes_type atts;
 
+    /// Get the metadata snapshot shared by all views of the dataset.
+    const std::shared_ptr<const metadata>& meta() const {
+        return meta_;
+    }
+
 private:
-    int ncid_;
+    std::shared_ptr<const metadata> meta_;
 };
 
 } // namespace ncpp
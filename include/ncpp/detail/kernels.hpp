@@ -0,0 +1,159 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_DETAIL_KERNELS_HPP
+#define NCPP_DETAIL_KERNELS_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace ncpp {
+namespace detail {
+
+// Elementwise kernels over contiguous ranges. These are written as simple
+// counted loops without branches so that they are auto-vectorized.
+
+// Unpack CF packed values, substituting NaN where valid is zero.
+template <class T, class U>
+inline void unpack_masked(const U *in, std::size_t n, T scale, T offset, const unsigned char *valid, T *out) noexcept
+{
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = valid[i] ? static_cast<T>(in[i]) * scale + offset : nan;
+}
+
+// Test values against an inclusive range and up to two sentinel values.
+// NaN is never valid. Writes 1 for valid values and 0 otherwise.
+template <class T>
+inline void validate(const T *in, std::size_t n, T lo, T hi, T fill, bool has_fill,
+                     T missing, bool has_missing, unsigned char *out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        const T x = in[i];
+        out[i] = static_cast<unsigned char>((x >= lo) & (x <= hi) &
+            ((x != fill) | !has_fill) & ((x != missing) | !has_missing));
+    }
+}
+
+// Accumulate the count, sum, minimum and maximum of values where valid is
+// nonzero.
+template <class T>
+inline void accumulate(const T *in, const unsigned char *valid, std::size_t n,
+                       std::size_t& count, double& sum, double& lo, double& hi) noexcept
+{
+    std::size_t c = 0;
+    double s = 0.0, l = lo, h = hi;
+    for (std::size_t i = 0; i < n; ++i) {
+        const double x = static_cast<double>(in[i]);
+        const bool v = valid[i] != 0;
+        c += v;
+        s += v ? x : 0.0;
+        l = (v && x < l) ? x : l;
+        h = (v && x > h) ? x : h;
+    }
+    count += c;
+    sum += s;
+    lo = l;
+    hi = h;
+}
+
+// Set bits [pos, pos + n) of a zero-initialized bitmap from a byte mask.
+inline void pack_bits(const unsigned char *in, std::size_t n, std::uint64_t *bits, std::size_t pos) noexcept
+{
+    std::size_t i = 0;
+    for (; i < n && (pos + i) % 64 != 0; ++i)
+        bits[(pos + i) / 64] |= std::uint64_t(in[i] != 0) << ((pos + i) % 64);
+
+    for (; i + 64 <= n; i += 64) {
+        std::uint64_t word = 0;
+        for (std::size_t j = 0; j < 64; ++j)
+            word |= std::uint64_t(in[i + j] != 0) << j;
+        bits[(pos + i) / 64] = word;
+    }
+
+    for (; i < n; ++i)
+        bits[(pos + i) / 64] |= std::uint64_t(in[i] != 0) << ((pos + i) % 64);
+}
+
+// Unsigned integer type with the same size as a value type.
+template <std::size_t N> struct uint_of_size;
+template <> struct uint_of_size<1> { using type = std::uint8_t; };
+template <> struct uint_of_size<2> { using type = std::uint16_t; };
+template <> struct uint_of_size<4> { using type = std::uint32_t; };
+template <> struct uint_of_size<8> { using type = std::uint64_t; };
+
+inline std::uint8_t byteswap(std::uint8_t x) noexcept
+{
+    return x;
+}
+
+inline std::uint16_t byteswap(std::uint16_t x) noexcept
+{
+    return static_cast<std::uint16_t>((x >> 8) | (x << 8));
+}
+
+inline std::uint32_t byteswap(std::uint32_t x) noexcept
+{
+    return ((x >> 24) & 0x000000FFu) | ((x >> 8) & 0x0000FF00u) |
+           ((x << 8) & 0x00FF0000u) | ((x << 24) & 0xFF000000u);
+}
+
+inline std::uint64_t byteswap(std::uint64_t x) noexcept
+{
+    return (std::uint64_t(byteswap(static_cast<std::uint32_t>(x))) << 32) |
+           byteswap(static_cast<std::uint32_t>(x >> 32));
+}
+
+// Load one big-endian value from unaligned memory.
+template <class T>
+inline T load_big_endian(const unsigned char *in) noexcept
+{
+    typename uint_of_size<sizeof(T)>::type u;
+    std::memcpy(&u, in, sizeof(T));
+#if !defined(__BYTE_ORDER__) || (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    u = byteswap(u);
+#endif
+    T x;
+    std::memcpy(&x, &u, sizeof(T));
+    return x;
+}
+
+// Copy n big-endian values from unaligned memory in native byte order.
+template <class T>
+inline void load_big_endian(const unsigned char *in, std::size_t n, T *out) noexcept
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    std::memcpy(out, in, n * sizeof(T));
+#else
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = load_big_endian<T>(in + i * sizeof(T));
+#endif
+}
+
+// Reverse the HDF5 shuffle filter over n bytes of values with a given size.
+// Shuffled data holds the first byte of every value, then the second, and
+// so on. Trailing bytes that do not form a whole value are not shuffled.
+inline void unshuffle(const unsigned char *in, std::size_t n, std::size_t typesize, unsigned char *out) noexcept
+{
+    const std::size_t nelems = (typesize > 0) ? n / typesize : 0;
+    for (std::size_t b = 0; b < typesize; ++b) {
+        const unsigned char *src = in + b * nelems;
+        for (std::size_t i = 0; i < nelems; ++i)
+            out[i * typesize + b] = src[i];
+    }
+    std::memcpy(out + nelems * typesize, in + nelems * typesize, n - nelems * typesize);
+}
+
+} // namespace detail
+} // namespace ncpp
+
+#endif // NCPP_DETAIL_KERNELS_HPP
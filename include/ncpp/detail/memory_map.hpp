@@ -0,0 +1,68 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_DETAIL_MEMORY_MAP_HPP
+#define NCPP_DETAIL_MEMORY_MAP_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+
+namespace ncpp {
+namespace detail {
+
+// Read-only mapping of a whole file, unmapped when the last reference is
+// released.
+struct memory_map
+{
+    std::shared_ptr<const void> data;
+    std::size_t size;
+};
+
+inline memory_map map_file(const std::filesystem::path& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category());
+
+    struct stat st;
+    void *addr = MAP_FAILED;
+    int err = EINVAL;
+    if (::fstat(fd, &st) != 0)
+        err = errno;
+    else if (st.st_size > 0) {
+        addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        err = errno;
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        throw std::system_error(err, std::generic_category());
+
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    return memory_map{ std::shared_ptr<const void>(addr, [size](const void *p) {
+        ::munmap(const_cast<void *>(p), size);
+    }), size };
+}
+
+} // namespace detail
+} // namespace ncpp
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+#endif // NCPP_DETAIL_MEMORY_MAP_HPP
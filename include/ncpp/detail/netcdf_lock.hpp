@@ -0,0 +1,39 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_DETAIL_NETCDF_LOCK_HPP
+#define NCPP_DETAIL_NETCDF_LOCK_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <mutex>
+
+namespace ncpp {
+namespace detail {
+
+// Lock held by worker threads around netCDF-C calls. The library is not
+// thread-safe, so all calls are serialized, even on different files. The
+// lock is re-entrant, so code that takes it may run under a caller that
+// already holds it, such as a task posted to an io_service.
+struct netcdf_lock
+{
+    static std::recursive_mutex& mutex()
+    {
+        static std::recursive_mutex m;
+        return m;
+    }
+
+    std::lock_guard<std::recursive_mutex> guard{ mutex() };
+};
+
+} // namespace detail
+} // namespace ncpp
+
+#endif // NCPP_DETAIL_NETCDF_LOCK_HPP
@@ -21,6 +21,20 @@
 namespace ncpp {
 namespace detail {
 
+// Get the smallest prime number not less than n.
+inline std::size_t next_prime(std::size_t n) noexcept
+{
+    if (n <= 2)
+        return 2;
+    for (n |= 1; ; n += 2) {
+        bool prime = true;
+        for (std::size_t k = 3; k * k <= n && prime; k += 2)
+            prime = (n % k != 0);
+        if (prime)
+            return n;
+    }
+}
+
 // Type trait to detect narrowing conversions. Adapted from MPark.Variant:
 // Copyright Michael Park, 2015-2017
 // Distributed under the Boost Software License, Version 1.0.
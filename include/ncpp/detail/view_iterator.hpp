@@ -0,0 +1,77 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_DETAIL_VIEW_ITERATOR_HPP
+#define NCPP_DETAIL_VIEW_ITERATOR_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <iterator>
+
+namespace ncpp {
+namespace detail {
+
+// Random access iterator over a container of lightweight views. Views are
+// returned by value on dereference, similar to std::vector<bool>. The
+// container must provide `value_type get(std::size_t n) const`.
+
+template <class Container>
+class view_iterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename Container::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+
+    struct pointer {
+        value_type value;
+        const value_type *operator->() const { return &value; }
+    };
+
+    view_iterator() = default;
+
+    view_iterator(const Container *c, std::size_t n)
+        : c_(c), n_(n) {}
+
+    reference operator*() const { return c_->get(n_); }
+    pointer operator->() const { return pointer{ c_->get(n_) }; }
+    reference operator[](difference_type k) const { return c_->get(n_ + k); }
+
+    view_iterator& operator++() { ++n_; return *this; }
+    view_iterator& operator--() { --n_; return *this; }
+    view_iterator operator++(int) { auto it = *this; ++n_; return it; }
+    view_iterator operator--(int) { auto it = *this; --n_; return it; }
+
+    view_iterator& operator+=(difference_type k) { n_ += k; return *this; }
+    view_iterator& operator-=(difference_type k) { n_ -= k; return *this; }
+    view_iterator operator+(difference_type k) const { return view_iterator(c_, n_ + k); }
+    view_iterator operator-(difference_type k) const { return view_iterator(c_, n_ - k); }
+    friend view_iterator operator+(difference_type k, const view_iterator& it) { return it + k; }
+
+    difference_type operator-(const view_iterator& rhs) const {
+        return static_cast<difference_type>(n_) - static_cast<difference_type>(rhs.n_);
+    }
+
+    bool operator==(const view_iterator& rhs) const { return c_ == rhs.c_ && n_ == rhs.n_; }
+    bool operator!=(const view_iterator& rhs) const { return !(*this == rhs); }
+    bool operator<(const view_iterator& rhs) const { return n_ < rhs.n_; }
+    bool operator>(const view_iterator& rhs) const { return n_ > rhs.n_; }
+    bool operator<=(const view_iterator& rhs) const { return n_ <= rhs.n_; }
+    bool operator>=(const view_iterator& rhs) const { return n_ >= rhs.n_; }
+
+private:
+    const Container *c_ = nullptr;
+    std::size_t n_ = 0;
+};
+
+} // namespace detail
+} // namespace ncpp
+
+#endif // NCPP_DETAIL_VIEW_ITERATOR_HPP
@@ -15,58 +15,41 @@
 
 #include <ncpp/config.hpp>
 
-#include <ncpp/functions/dataset.hpp>
-#include <ncpp/functions/dimension.hpp>
-#include <ncpp/functions/variable.hpp>
-#include <ncpp/check.hpp>
+#include <ncpp/metadata.hpp>
 
-#include <algorithm>
+#include <memory>
 #include <string>
-#include <vector>
+#include <utility>
 
 namespace ncpp {
 
 class dimensions_type;
 class variable;
 
-/// netCDF dimension type.
+/// netCDF dimension type. Lightweight view on the dataset metadata.
 class dimension
 {
     friend class dimensions_type;
     friend class variable;
 
 public:
+    dimension(std::shared_ptr<const metadata> meta, int dimid)
+        : meta_(std::move(meta)), info_(&meta_->dim(dimid)), cvarid_(info_->cvarid)
+    {}
+
+    /// Construct a view on a new metadata snapshot of the dataset. Only the
+    /// dimensions and variable IDs are read up front; use the constructor
+    /// taking a shared snapshot for several views of one dataset.
     dimension(int ncid, int dimid)
-        : ncid_(ncid), dimid_(dimid), cvarid_(-1)
-    {
-        // Get the coordinate variable id associated with the dimension, if any.
-        // See also: iscoordvar function in netcdf-c/ncdump/dumplib.c
-
-        int cvarid = api::inq_varid(ncid, name()).value_or(-1);
-        if (cvarid == -1)
-            return;
-        
-        int cvartype = api::inq_vartype(ncid, cvarid);
-        auto cvardimids = api::inq_vardimid(ncid, cvarid);
-
-        // Ensure the variable is one-dimensional; allow two dimensions for classic strings.
-        if ((cvartype != NC_CHAR && cvardimids.size() != 1) ||
-            (cvartype == NC_CHAR && cvardimids.size() > 2))
-            return;
-
-        // Ensure the variable is indexed by this dimension.
-        if (cvardimids.at(0) != dimid)
-            return;
-        
-        cvarid_ = cvarid;
-    }
+        : dimension(std::make_shared<const metadata>(ncid), dimid)
+    {}
 
     bool operator<(const dimension& rhs) const {
-        return (dimid_ < rhs.dimid_);
+        return (dimid() < rhs.dimid());
     }
 
     bool operator==(const dimension& rhs) const {
-        return (ncid_ == rhs.ncid_ && dimid_ == rhs.dimid_);
+        return (ncid() == rhs.ncid() && dimid() == rhs.dimid());
     }
 
     bool operator!=(const dimension& rhs) const {
@@ -74,39 +57,41 @@ public:
     }
 
     /// Get the dimension name.
-    std::string name() const
+    const std::string& name() const
     {
-        return api::inq_dimname(ncid_, dimid_);
+        return info_->name;
     }
 
     /// Get the netCDF ID.
     int ncid() const {
-        return ncid_;
+        return meta_->ncid();
     }
 
     /// Get the dimension ID.
     int dimid() const
     {
-        return dimid_;
+        return info_->dimid;
     }
 
-    /// Get the dimension length.
+    /// Get the dimension length when the dataset was opened.
     std::size_t length() const
     {
-        return api::inq_dimlen(ncid_, dimid_);
+        return info_->length;
     }
     
     /// Returns true if the dimension is unlimited.
     bool is_unlimited() const
     {
-        std::vector<int> unlim = api::inq_unlimdims(ncid_);
-        auto it = std::find(unlim.begin(), unlim.end(), dimid_);
-        return (it != unlim.end());
+        return info_->unlimited;
     }
 
 private:
-    int ncid_;
-    int dimid_;
+    dimension(std::shared_ptr<const metadata> meta, int dimid, int cvarid)
+        : meta_(std::move(meta)), info_(&meta_->dim(dimid)), cvarid_(cvarid)
+    {}
+
+    std::shared_ptr<const metadata> meta_;
+    const metadata::dimension_info *info_;
     int cvarid_;
 };
 
@@ -15,124 +15,129 @@
 
 #include <ncpp/config.hpp>
 
-#include <ncpp/functions/dimension.hpp>
-#include <ncpp/functions/variable.hpp>
+#include <ncpp/detail/view_iterator.hpp>
 #include <ncpp/dimension.hpp>
+#include <ncpp/metadata.hpp>
 #include <ncpp/check.hpp>
 
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace ncpp {
 
 class dataset;
 class variable;
+class indexed_variable;
 
 /// netCDF dimension sequence container.
 class dimensions_type
 {
     friend class dataset;
     friend class variable;
+    friend class indexed_variable;
+    friend class detail::view_iterator<dimensions_type>;
 
 public:
-    using storage_type = std::vector<dimension>;
-    using value_type = typename storage_type::value_type;
-    using iterator = storage_type::iterator;
-    using const_iterator = storage_type::const_iterator;
-    using reference = storage_type::reference;
-    using const_reference = storage_type::const_reference;
+    using value_type = dimension;
+    using iterator = detail::view_iterator<dimensions_type>;
+    using const_iterator = iterator;
+    using reference = value_type;
+    using const_reference = value_type;
     
-    explicit dimensions_type(int ncid)
-        : ncid_(ncid), varid_(NC_GLOBAL)
-    {
-        auto dimids = api::inq_dimids(ncid);
-        dims_.reserve(dimids.size());
-        for (const auto& dimid : dimids)
-            dims_.emplace_back(dimension(ncid, dimid));
-    }
-
-    dimensions_type(int ncid, int varid)
-        : ncid_(ncid), varid_(varid)
-    {
-        auto dimids = api::inq_vardimid(ncid, varid);
-        dims_.reserve(dimids.size());
-        for (const auto& dimid : dimids)
-            dims_.emplace_back(dimension(ncid, dimid));
-    }
-
-    iterator begin() noexcept {
-        return dims_.begin();
-    }
-
-    iterator end() noexcept {
-        return dims_.end();
-    }
-    
-    const_iterator begin() const noexcept {
-        return dims_.begin();
+    /// Dimensions of the dataset.
+    explicit dimensions_type(std::shared_ptr<const metadata> meta)
+        : meta_(std::move(meta)), varid_(NC_GLOBAL)
+    {}
+
+    /// Dimensions of a variable.
+    dimensions_type(std::shared_ptr<const metadata> meta, int varid)
+        : meta_(std::move(meta)), varid_(varid)
+    {}
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
     }
 
-    const_iterator end() const noexcept {
-        return dims_.end();
+    const_iterator end() const {
+        return const_iterator(this, size());
     }
 
     const_reference front() const {
-        return *dims_.cbegin();
+        return get(0);
     }
 
     const_reference back() const {
-        return *dims_.cend();
+        return get(size() - 1);
     }
 
-    std::size_t size() const noexcept {
-        return dims_.size();
+    std::size_t size() const {
+        return (varid_ == NC_GLOBAL) ? meta_->dims().size()
+                                     : meta_->var(varid_).dimids.size();
     }
 
-    bool empty() const noexcept {
-        return dims_.empty();
+    bool empty() const {
+        return size() == 0;
     }
 
     /// Get a dimension from its name.
-    const_reference operator[](const std::string& name) const
+    const_reference operator[](std::string_view name) const
     {
-        auto dimid = api::inq_dimid(ncid_, name);
-        if (!dimid.has_value())
-            detail::throw_error(error::invalid_dimension);
-        
-        const auto it = std::find(dims_.begin(), dims_.end(), dimension(ncid_, dimid.value()));
-        if (it == dims_.end())
+        auto n = position(name);
+        if (!n.has_value())
             detail::throw_error(error::invalid_dimension);
 
-        return *it;
+        return get(n.value());
     }
 
     /// Get a dimension by index.
     const_reference at(std::size_t n) const
     {
-        if (n >= dims_.size())
+        if (n >= size())
             detail::throw_error(error::invalid_dimension);
 
-        auto it = dims_.begin();
-        std::advance(it, n);
-        return *it;
+        return get(n);
     }
 
     /// Determine if a dimension is present.
-    bool contains(const std::string& name) const noexcept
+    bool contains(std::string_view name) const noexcept
     {
-        std::error_code ec;
-        auto dimid = api::inq_dimid(ncid_, name, ec);
-        if (ec.value() || !dimid.has_value())
-            return false;
-        
-        const auto it = std::find(dims_.begin(), dims_.end(), dimension(ncid_, dimid.value()));
-        return (it != dims_.end());
+        return position(name).has_value();
     }
 
 private:
-    int ncid_;
+    int dimid(std::size_t n) const
+    {
+        return (varid_ == NC_GLOBAL) ? meta_->dims()[n].dimid
+                                     : meta_->var(varid_).dimids[n];
+    }
+
+    value_type get(std::size_t n) const
+    {
+        int id = dimid(n);
+        int cvarid = cvarids_.empty() ? meta_->dim(id).cvarid : cvarids_[n];
+        return dimension(meta_, id, cvarid);
+    }
+
+    std::optional<std::size_t> position(std::string_view name) const noexcept
+    {
+        auto id = meta_->find_dim(name);
+        if (!id.has_value())
+            return std::nullopt;
+
+        for (std::size_t n = 0, len = size(); n < len; ++n) {
+            if (dimid(n) == id.value())
+                return n;
+        }
+        return std::nullopt;
+    }
+
+    std::shared_ptr<const metadata> meta_;
     int varid_;
-    storage_type dims_;
+    std::vector<int> cvarids_; // coordinate variable overrides, if any
 };
 
 } // namespace ncpp
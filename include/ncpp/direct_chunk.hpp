@@ -0,0 +1,383 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_DIRECT_CHUNK_HPP
+#define NCPP_DIRECT_CHUNK_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <netcdf.h>
+
+#include <ncpp/config.hpp>
+
+#if defined(NCPP_USE_HDF5)
+
+#include <hdf5.h>
+#include <zlib.h>
+
+#if defined(NCPP_USE_ZSTD)
+#include <zstd.h>
+#endif
+
+#include <ncpp/detail/kernels.hpp>
+#include <ncpp/detail/netcdf_lock.hpp>
+#include <ncpp/functions/ndarray.hpp>
+#include <ncpp/thread_pool.hpp>
+#include <ncpp/variable.hpp>
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+
+/// Reader for chunked netCDF-4 variables that bypasses the HDF5 filter
+/// pipeline. Raw chunks are read with H5Dread_chunk on the calling thread,
+/// then decompressed and copied to the output on a thread pool. Deflate and
+/// shuffle are supported, and Zstandard if NCPP_USE_ZSTD is defined. Reads
+/// of variables with other filters, or of types that need conversion, fall
+/// back to netCDF-C. Requires HDF5 1.10.2 or later.
+class direct_chunk_reader
+{
+public:
+    /// Open the HDF5 dataset for a variable selection.
+    explicit direct_chunk_reader(const variable& var)
+        : var_(var)
+    {
+        detail::netcdf_lock lock;
+
+        std::size_t len;
+        check(nc_inq_path(var.ncid(), &len, nullptr));
+        std::string path(len, '\0');
+        check(nc_inq_path(var.ncid(), nullptr, &path[0]));
+
+        check(nc_inq_grpname_full(var.ncid(), &len, nullptr));
+        std::string group(len, '\0');
+        check(nc_inq_grpname_full(var.ncid(), nullptr, &group[0]));
+        const std::string name = (group == "/" ? group : group + "/") + var.name();
+
+        H5E_BEGIN_TRY {
+            file_ = H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+            if (file_ >= 0)
+                dset_ = H5Dopen2(file_, name.c_str(), H5P_DEFAULT);
+            if (dset_ >= 0)
+                supported_ = inspect();
+        } H5E_END_TRY;
+    }
+
+    direct_chunk_reader(const direct_chunk_reader&) = delete;
+    direct_chunk_reader& operator=(const direct_chunk_reader&) = delete;
+
+    ~direct_chunk_reader()
+    {
+        detail::netcdf_lock lock;
+        if (dset_ >= 0)
+            H5Dclose(dset_);
+        if (file_ >= 0)
+            H5Fclose(file_);
+    }
+
+    /// Returns true if the filter pipeline of the variable can be decoded
+    /// without HDF5.
+    bool is_supported() const noexcept {
+        return supported_;
+    }
+
+    /// Copy values to allocated memory. Chunks are decoded on a thread pool,
+    /// with at most two chunks per worker held in memory.
+    template <class T>
+    void read(T *out, thread_pool& pool) const
+    {
+        if (!supported_ || !compatible<T>()) {
+            detail::netcdf_lock lock;
+            var_.read(out);
+            return;
+        }
+
+        const index_type& start = var_.start();
+        const index_type& count = var_.shape();
+        const stride_type& stride = var_.stride();
+        const std::size_t ndims = count.size();
+        if (api::compute_size(count) == 0)
+            return;
+
+        // Segments of the selection within each chunk, for each dimension.
+        std::vector<std::vector<std::pair<std::size_t, std::size_t>>> segments(ndims);
+        for (std::size_t d = 0; d < ndims; ++d)
+            segments[d] = api::compute_chunk_segments(start[d], count[d], stride[d], chunkshape_[d]);
+
+        const std::size_t depth = 2 * pool.size();
+        std::deque<std::future<void>> pending;
+        index_type k(ndims, 0), position(ndims), blockcount(ndims);
+        std::vector<hsize_t> offset(ndims);
+
+        try {
+            for (;;) {
+                for (std::size_t d = 0; d < ndims; ++d) {
+                    const auto& s = segments[d][k[d]];
+                    position[d] = s.first;
+                    blockcount[d] = s.second;
+                    offset[d] = (start[d] + s.first * static_cast<std::size_t>(stride[d])) / chunkshape_[d] * chunkshape_[d];
+                }
+
+                auto raw = std::make_shared<std::vector<unsigned char>>();
+                std::uint32_t filter_mask = 0;
+                if (read_raw(offset, *raw, filter_mask)) {
+                    pending.emplace_back(pool.submit([this, raw, filter_mask, offset, position, blockcount, out] {
+                        const auto chunk = decode(std::move(*raw), filter_mask);
+                        scatter(chunk.data(), offset, position, blockcount, out);
+                    }));
+                    if (pending.size() >= depth) {
+                        pending.front().get();
+                        pending.pop_front();
+                    }
+                }
+                else {
+                    // Chunks that were never written hold the fill value.
+                    read_fill(position, blockcount, out);
+                }
+
+                std::size_t d = ndims;
+                for (; d != 0; --d) {
+                    if (++k[d-1] < segments[d-1].size())
+                        break;
+                    k[d-1] = 0;
+                }
+                if (d == 0)
+                    break;
+            }
+            while (!pending.empty()) {
+                pending.front().get();
+                pending.pop_front();
+            }
+        }
+        catch (...) {
+            // Tasks refer to the output, so wait for them before unwinding.
+            for (auto& f : pending)
+                f.wait();
+            throw;
+        }
+    }
+
+    /// Get values as std::vector.
+    template <class T, class A = std::allocator<T>>
+    std::vector<T, A> values(thread_pool& pool) const
+    {
+        std::vector<T, A> result(var_.size());
+        read(result.data(), pool);
+        return result;
+    }
+
+private:
+    static constexpr unsigned int filter_zstd = 32015;
+
+    // Check the layout and filters of the dataset.
+    bool inspect()
+    {
+        hid_t dcpl = H5Dget_create_plist(dset_);
+        hid_t type = H5Dget_type(dset_);
+        bool ok = (dcpl >= 0 && type >= 0 && H5Pget_layout(dcpl) == H5D_CHUNKED);
+
+        if (ok) {
+            const std::size_t ndims = var_.shape().size();
+            std::vector<hsize_t> dims(ndims);
+            ok = (H5Pget_chunk(dcpl, static_cast<int>(ndims), dims.data()) == static_cast<int>(ndims));
+            for (std::size_t d = 0; ok && d < ndims; ++d)
+                chunkshape_.push_back(static_cast<std::size_t>(dims[d]));
+
+            typesize_ = H5Tget_size(type);
+            swap_ = (H5Tget_order(type) != H5Tget_order(H5T_NATIVE_INT));
+            floating_ = (H5Tget_class(type) == H5T_FLOAT);
+            signed_ = floating_ || (H5Tget_sign(type) == H5T_SGN_2);
+            ok = ok && (H5Tget_class(type) == H5T_INTEGER || floating_);
+            chunkbytes_ = typesize_ * api::compute_size(chunkshape_);
+
+            const int nfilters = H5Pget_nfilters(dcpl);
+            for (int i = 0; ok && i < nfilters; ++i) {
+                unsigned int flags;
+                std::size_t nelmts = 0;
+                const H5Z_filter_t id = H5Pget_filter2(dcpl, static_cast<unsigned int>(i), &flags, &nelmts, nullptr, 0, nullptr, nullptr);
+                ok = (id == H5Z_FILTER_DEFLATE || id == H5Z_FILTER_SHUFFLE);
+#if defined(NCPP_USE_ZSTD)
+                ok = ok || (id == filter_zstd);
+#endif
+                filters_.push_back(static_cast<unsigned int>(id));
+            }
+        }
+
+        if (type >= 0)
+            H5Tclose(type);
+        if (dcpl >= 0)
+            H5Pclose(dcpl);
+        return ok;
+    }
+
+    // Returns true if T has the size, class and signedness of the stored
+    // type, so chunks can be copied without conversion.
+    template <class T>
+    bool compatible() const noexcept {
+        return std::is_arithmetic<T>::value && sizeof(T) == typesize_ &&
+               std::is_floating_point<T>::value == floating_ && std::is_signed<T>::value == signed_;
+    }
+
+    // Read a raw chunk. Returns false if the chunk is not allocated.
+    bool read_raw(const std::vector<hsize_t>& offset, std::vector<unsigned char>& raw, std::uint32_t& filter_mask) const
+    {
+        detail::netcdf_lock lock;
+        hsize_t nbytes = 0;
+        herr_t rc;
+        H5E_BEGIN_TRY {
+            rc = H5Dget_chunk_storage_size(dset_, offset.data(), &nbytes);
+        } H5E_END_TRY;
+        if (rc < 0 || nbytes == 0)
+            return false;
+
+        raw.resize(static_cast<std::size_t>(nbytes));
+        if (H5Dread_chunk(dset_, H5P_DEFAULT, offset.data(), &filter_mask, raw.data()) < 0)
+            detail::throw_error(error::hdf5_error);
+        return true;
+    }
+
+    // Undo the filters in reverse order, skipping those not applied.
+    std::vector<unsigned char> decode(std::vector<unsigned char> buffer, std::uint32_t filter_mask) const
+    {
+        std::vector<unsigned char> tmp;
+        for (std::size_t i = filters_.size(); i-- > 0; ) {
+            if (filter_mask & (1u << i))
+                continue;
+
+            tmp.resize(chunkbytes_);
+            switch (filters_[i]) {
+            case H5Z_FILTER_DEFLATE: {
+                uLongf n = static_cast<uLongf>(tmp.size());
+                if (uncompress(tmp.data(), &n, buffer.data(), static_cast<uLong>(buffer.size())) != Z_OK)
+                    detail::throw_error(error::hdf5_error);
+                tmp.resize(n);
+                break;
+            }
+            case H5Z_FILTER_SHUFFLE:
+                tmp.resize(buffer.size());
+                detail::unshuffle(buffer.data(), buffer.size(), typesize_, tmp.data());
+                break;
+#if defined(NCPP_USE_ZSTD)
+            case filter_zstd: {
+                const std::size_t n = ZSTD_decompress(tmp.data(), tmp.size(), buffer.data(), buffer.size());
+                if (ZSTD_isError(n))
+                    detail::throw_error(error::hdf5_error);
+                tmp.resize(n);
+                break;
+            }
+#endif
+            default:
+                detail::throw_error(error::hdf5_error);
+            }
+            buffer.swap(tmp);
+        }
+
+        if (buffer.size() < chunkbytes_)
+            detail::throw_error(error::hdf5_error);
+        return buffer;
+    }
+
+    // Copy the selected elements of a decoded chunk to the output.
+    template <class T>
+    void scatter(const unsigned char *chunk, const std::vector<hsize_t>& offset,
+                 const index_type& position, const index_type& blockcount, T *out) const
+    {
+        const index_type& start = var_.start();
+        const index_type& outshape = var_.shape();
+        const stride_type& stride = var_.stride();
+        const std::size_t ndims = outshape.size();
+
+        // Row of the block along the last dimension.
+        const std::size_t n = blockcount[ndims-1];
+        const std::size_t step = static_cast<std::size_t>(stride[ndims-1]);
+        index_type k(ndims - 1, 0);
+        for (;;) {
+            std::size_t src = 0, dst = 0;
+            for (std::size_t d = 0; d < ndims; ++d) {
+                const std::size_t i = (d + 1 < ndims) ? position[d] + k[d] : position[d];
+                src = src * chunkshape_[d] + (start[d] + i * static_cast<std::size_t>(stride[d]) - offset[d]);
+                dst = dst * outshape[d] + i;
+            }
+
+            const unsigned char *p = chunk + src * sizeof(T);
+            if (!swap_ && step == 1)
+                std::memcpy(out + dst, p, n * sizeof(T));
+            else {
+                using U = typename detail::uint_of_size<sizeof(T)>::type;
+                for (std::size_t j = 0; j < n; ++j) {
+                    U u;
+                    std::memcpy(&u, p + j * step * sizeof(T), sizeof(T));
+                    if (swap_)
+                        u = detail::byteswap(u);
+                    std::memcpy(out + dst + j, &u, sizeof(T));
+                }
+            }
+
+            std::size_t d = ndims - 1;
+            for (; d != 0; --d) {
+                if (++k[d-1] < blockcount[d-1])
+                    break;
+                k[d-1] = 0;
+            }
+            if (d == 0)
+                break;
+        }
+    }
+
+    // Read a block through netCDF-C, which applies the fill value.
+    template <class T>
+    void read_fill(const index_type& position, const index_type& blockcount, T *out) const
+    {
+        const std::size_t ndims = position.size();
+        index_type start(ndims);
+        for (std::size_t d = 0; d < ndims; ++d)
+            start[d] = var_.start()[d] + position[d] * static_cast<std::size_t>(var_.stride()[d]);
+
+        std::vector<T> buffer(api::compute_size(blockcount));
+        {
+            detail::netcdf_lock lock;
+            check(api::impl::detail::get_vars(var_.ncid(), var_.varid(), start.data(), blockcount.data(),
+                var_.stride().data(), buffer.data()));
+        }
+        api::for_each_row(position, blockcount, var_.shape(),
+            [&](std::size_t src, std::size_t dst, std::size_t n) {
+                std::copy_n(buffer.data() + src, n, out + dst);
+            });
+    }
+
+    variable var_;
+    hid_t file_ = -1;
+    hid_t dset_ = -1;
+    bool supported_ = false;
+    bool swap_ = false;
+    bool floating_ = false;
+    bool signed_ = false;
+    std::size_t typesize_ = 0;
+    std::size_t chunkbytes_ = 0;
+    index_type chunkshape_;
+    std::vector<unsigned int> filters_;
+};
+
+} // namespace ncpp
+
+#endif // defined(NCPP_USE_HDF5)
+
+#endif // NCPP_DIRECT_CHUNK_HPP
@@ -12,18 +12,58 @@
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
 #include <netcdf.h>
+#include <netcdf_mem.h>
 
 #include <ncpp/config.hpp>
 
+#include <ncpp/detail/memory_map.hpp>
 #include <ncpp/check.hpp>
 
+#include <cstddef>
+#include <cstdlib>
 #include <filesystem>
+#include <memory>
 #include <string>
+#include <utility>
 
 namespace ncpp {
 
 class dataset;
 
+/// Contents of an in-memory dataset, returned by file::close_memory().
+class memory_buffer
+{
+public:
+    memory_buffer(void *data, std::size_t size)
+        : data_(static_cast<unsigned char *>(data)), size_(size)
+    {}
+
+    /// Get a pointer to the contents.
+    const unsigned char *data() const noexcept {
+        return data_.get();
+    }
+
+    /// Get the size of the contents in bytes.
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    /// Release ownership of the contents, which must be freed with std::free.
+    unsigned char *release() noexcept {
+        size_ = 0;
+        return data_.release();
+    }
+
+private:
+    struct free_deleter
+    {
+        void operator()(unsigned char *p) const noexcept { std::free(p); }
+    };
+
+    std::unique_ptr<unsigned char, free_deleter> data_;
+    std::size_t size_;
+};
+
 /// netCDF file type.
 class file
 {
@@ -66,8 +106,73 @@ public:
         check(rc);
     }
 
+    file(const file&) = delete;
+    file& operator=(const file&) = delete;
+
+    file(file&& rhs) noexcept
+        : ncid_(std::exchange(rhs.ncid_, -1)), _path(std::move(rhs._path)), mapping_(std::move(rhs.mapping_))
+    {}
+
+    file& operator=(file&& rhs) noexcept
+    {
+        if (this != &rhs) {
+            if (ncid_ >= 0)
+                nc_close(ncid_);
+            ncid_ = std::exchange(rhs.ncid_, -1);
+            _path = std::move(rhs._path);
+            mapping_ = std::move(rhs.mapping_);
+        }
+        return *this;
+    }
+
     ~file() {
-        nc_close(ncid_);
+        if (ncid_ >= 0)
+            nc_close(ncid_);
+    }
+
+    /// Open a dataset read-only from a caller-owned buffer, without copying.
+    /// The buffer must remain valid until the file is closed.
+    static file open_memory(const void *data, std::size_t size, const std::string& name = "memory")
+    {
+        int ncid;
+        check(nc_open_mem(name.c_str(), NC_NOWRITE, size, const_cast<void *>(data), &ncid));
+        return file(ncid, name, nullptr);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+
+    /// Open a dataset read-only from a memory mapping of a file. Pages are
+    /// read on demand by the operating system and shared with the page cache.
+    static file map(const std::filesystem::path& path)
+    {
+        auto mapping = detail::map_file(path);
+        void *addr = const_cast<void *>(mapping.data.get());
+
+        int ncid;
+        check(nc_open_mem(path.string().c_str(), NC_NOWRITE, mapping.size, addr, &ncid));
+        return file(ncid, path, std::move(mapping.data));
+    }
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+    /// Create an in-memory (diskless) dataset. The contents are returned by
+    /// close_memory(). The format is netCDF-4 by default; pass 0,
+    /// NC_64BIT_OFFSET or NC_64BIT_DATA for the classic formats.
+    static file create_memory(const std::string& name = "memory", std::size_t initial_size = 0, int cmode = NC_NETCDF4)
+    {
+        int ncid;
+        check(nc_create_mem(name.c_str(), cmode, initial_size, &ncid));
+        return file(ncid, name, nullptr);
+    }
+
+    /// Close an in-memory dataset and return its contents.
+    memory_buffer close_memory()
+    {
+        NC_memio info = {};
+        int rc = nc_close_memio(ncid_, &info);
+        ncid_ = -1;
+        check(rc);
+        return memory_buffer(info.memory, info.size);
     }
     
     /// Get the netCDF ID.
@@ -115,8 +220,13 @@ public:
     }
 
 private:
-    int ncid_;
+    file(int ncid, const std::filesystem::path& path, std::shared_ptr<const void> mapping)
+        : ncid_(ncid), _path(path), mapping_(std::move(mapping))
+    {}
+
+    int ncid_ = -1;
     std::filesystem::path _path;
+    std::shared_ptr<const void> mapping_; // unmapped after the file is closed
 };
 
 } // namespace ncpp
@@ -32,6 +32,13 @@ inline chunk_cache get_chunk_cache(std::error_code *ec = nullptr)
     return result;
 }
 
+// Set the default chunk cache settings for files opened or created
+// afterwards.
+inline void set_chunk_cache(const chunk_cache& cache, std::error_code *ec = nullptr)
+{
+    check(nc_set_chunk_cache(cache.size, cache.nelems, cache.preemption), ec);
+}
+
 } // namespace impl
 
 
@@ -46,6 +53,10 @@ inline chunk_cache get_chunk_cache(std::error_code &ec)
     { return impl::get_chunk_cache(&ec); }
 inline chunk_cache get_chunk_cache()
     { return impl::get_chunk_cache(); }
+inline void set_chunk_cache(const chunk_cache& cache, std::error_code &ec)
+    { impl::set_chunk_cache(cache, &ec); }
+inline void set_chunk_cache(const chunk_cache& cache)
+    { impl::set_chunk_cache(cache); }
 
 
 } // namespace api
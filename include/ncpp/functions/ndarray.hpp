@@ -21,6 +21,7 @@
 #include <iterator>
 #include <numeric>
 #include <system_error>
+#include <utility>
 #include <vector>
 
 namespace ncpp {
@@ -34,7 +35,7 @@ inline stride_type compute_strides(const index_type& shape)
     std::ptrdiff_t product = 1;
     for (std::size_t i = shape.size(); i != 0; --i) {
         strides[i-1] = shape[i-1] == 1 ? 0 : product;
-        product = strides[i-1] * static_cast<std::ptrdiff_t>(shape[i-1]);
+        product *= static_cast<std::ptrdiff_t>(shape[i-1]);
     }
     return strides;
 }
@@ -111,12 +112,13 @@ inline std::size_t compute_size(const index_type& shape)
 // subarrays. Returns the adjusted block size.
 inline std::size_t compute_block_size(std::size_t blocksize, const index_type& shape, const index_type& start, index_type& count)
 {
-    assert(shape.size() == start.size() == count.size());
+    assert(shape.size() == start.size() && shape.size() == count.size());
 
-    // Find the first dimension where blocksize is less than stride.
+    // Find the first dimension where blocksize is at least the stride.
+    // Single-element dimensions have zero stride and are skipped.
     stride_type strides = compute_strides(shape);
-    auto it = std::partition_point(strides.begin(), strides.end(),
-        [=](auto x) { return static_cast<std::ptrdiff_t>(blocksize) < x; });
+    auto it = std::find_if(strides.begin(), strides.end(),
+        [=](auto x) { return x != 0 && x <= static_cast<std::ptrdiff_t>(blocksize); });
 
     auto dim = std::distance(strides.begin(), it);
 
@@ -136,7 +138,7 @@ inline std::size_t compute_block_size(std::size_t blocksize, const index_type& s
             if (strides.at(i) != 0) {
                 auto q = std::div(static_cast<std::ptrdiff_t>(n), strides.at(i));
                 n = q.rem;
-                count.at(i) = std::max(q.quot, 1LL);
+                count.at(i) = static_cast<std::size_t>(std::max<std::ptrdiff_t>(q.quot, 1));
             }
         }
     }
@@ -144,6 +146,84 @@ inline std::size_t compute_block_size(std::size_t blocksize, const index_type& s
     return blocksize;
 }
 
+// Calculate the largest tile shape with at most blocksize elements, filling
+// trailing dimensions first so that tile rows are contiguous. Used in place
+// of a chunk shape for contiguous variables. Assumes row-major order.
+inline index_type compute_tile_shape(std::size_t blocksize, const index_type& shape)
+{
+    index_type tile(shape.size(), 1);
+    std::size_t n = std::max<std::size_t>(blocksize, 1);
+    for (std::size_t i = shape.size(); i != 0; --i) {
+        std::size_t len = std::max<std::size_t>(shape[i-1], 1);
+        if (len > n) {
+            tile[i-1] = n;
+            break;
+        }
+        tile[i-1] = len;
+        n /= len;
+    }
+    return tile;
+}
+
+// Split a strided range of a dimension into segments aligned to the chunk
+// grid. Returns pairs of (first position in range, number of elements).
+inline std::vector<std::pair<std::size_t, std::size_t>>
+compute_chunk_segments(std::size_t start, std::size_t count, std::ptrdiff_t stride, std::size_t chunklen)
+{
+    assert(stride > 0 && chunklen > 0);
+    std::vector<std::pair<std::size_t, std::size_t>> segments;
+    const std::size_t step = static_cast<std::size_t>(stride);
+    for (std::size_t k = 0; k < count; /**/) {
+        std::size_t index = start + k * step;
+        std::size_t end = (index / chunklen + 1) * chunklen;
+        std::size_t last = std::min(count - 1, (end - 1 - start) / step);
+        segments.emplace_back(k, last - k + 1);
+        k = last + 1;
+    }
+    return segments;
+}
+
+// Call f(src, dst, n) for each contiguous row of a block within an array,
+// where src and dst are the linear offsets of the row in the block and in
+// the array, and n is the row length. Assumes row-major order.
+template <class F>
+inline void for_each_row(const index_type& position, const index_type& count, const index_type& shape, F&& f)
+{
+    assert(shape.size() == position.size() && shape.size() == count.size());
+
+    const std::size_t ndims = shape.size();
+    if (ndims == 0) {
+        f(std::size_t(0), std::size_t(0), std::size_t(1));
+        return;
+    }
+
+    if (std::find(count.begin(), count.end(), 0) != count.end())
+        return;
+
+    index_type strides(ndims, 1);
+    for (std::size_t i = ndims - 1; i != 0; --i)
+        strides[i-1] = strides[i] * shape[i];
+
+    const std::size_t rowlen = count.back();
+    index_type index(ndims, 0);
+    for (std::size_t src = 0; /**/; src += rowlen) {
+        std::size_t dst = 0;
+        for (std::size_t i = 0; i < ndims; ++i)
+            dst += (position[i] + index[i]) * strides[i];
+        f(src, dst, rowlen);
+
+        // Advance the row index in row-major order.
+        std::size_t i = ndims - 1;
+        for (; i != 0; --i) {
+            if (++index[i-1] < count[i-1])
+                break;
+            index[i-1] = 0;
+        }
+        if (i == 0)
+            break;
+    }
+}
+
 } // namespace api
 } // namespace ncpp
 
@@ -274,6 +274,12 @@ inline chunk_cache get_var_chunk_cache(int ncid, int varid, std::error_code *ec
     return result;
 }
 
+// Set the per-variable chunk cache settings in the HDF5 layer.
+inline void set_var_chunk_cache(int ncid, int varid, const chunk_cache& cache, std::error_code *ec = nullptr)
+{
+    check(nc_set_var_chunk_cache(ncid, varid, cache.size, cache.nelems, cache.preemption), ec);
+}
+
 namespace detail {
 
     inline int put_var1(int ncid, int varid, const std::size_t *indexp, const char *op)
@@ -559,7 +565,8 @@ get_vars(int ncid, int varid,
     if (ec && ec->value())
         return result;
 
-    if (ndims <= 0 || start.size() != ndims || count.size() != ndims || stride.size() != ndims) {
+    // Scalar variables have no dimensions and a single value.
+    if (ndims < 0 || start.size() != ndims || count.size() != ndims || stride.size() != ndims) {
         check(NC_EINVALCOORDS, ec); // Index exceeds dimension bound
         return result;
     }
@@ -682,7 +689,7 @@ get_var1(int ncid, int varid, const index_type& start, std::error_code *ec = nul
     if (ec && ec->value())
         return result;
     
-    if (start.size() != shape.size()) {
+    if (start.size() != static_cast<std::size_t>(ndims)) {
         check(NC_EINVALCOORDS, ec); // Index exceeds dimension bound
         return result;
     }
@@ -693,7 +700,7 @@ get_var1(int ncid, int varid, const index_type& start, std::error_code *ec = nul
 
     if (nct == NC_CHAR) {
         // For classic strings, the character position is the last dimension.
-        index_type shape = get_varshape(ncid, varid, ec);
+        index_type shape = inq_varshape(ncid, varid, ec);
         if (ec && ec->value())
             return result;
         
@@ -707,9 +714,9 @@ get_var1(int ncid, int varid, const index_type& start, std::error_code *ec = nul
         char *ip = nullptr;
         check(nc_get_var1_string(ncid, varid, start.data(), &ip), ec);
         if ((ec && !ec->value()) || ip)
-            result = std::string(ip);result.reserve(n);
+            result = std::string(ip);
         
-        nc_free_string(n, &ip);
+        nc_free_string(1, &ip);
     }
     else {
         check(NC_ECHAR, ec); // Attempt to convert between text & numbers
@@ -816,10 +823,10 @@ get_vars(int ncid, int varid,
          const stride_type& stride,
          std::error_code *ec = nullptr)
 {
-    using T = Container::value_type;
+    using T = typename Container::value_type;
     Container result;
 
-    auto cft = parse_cf_time<T::clock, T::duration>(ncid, varid, ec);
+    auto cft = parse_cf_time<typename T::clock, typename T::duration>(ncid, varid, ec);
     if (ec && ec->value())
         return result;
     
@@ -830,7 +837,7 @@ get_vars(int ncid, int varid,
     result.resize(offsets.size());
     for (std::size_t i = 0; i < offsets.size(); ++i) {
         std::chrono::duration<double> sec(offsets[i] * cft.scale);
-        result.at(i) = cft.start + std::chrono::duration_cast<T::duration>(sec);
+        result.at(i) = cft.start + std::chrono::duration_cast<typename T::duration>(sec);
     }
     
     return result;
@@ -843,7 +850,7 @@ get_var1(int ncid, int varid, const index_type& start, std::error_code *ec = nul
 {
     T result;
 
-    auto cft = parse_cf_time<T::clock, T::duration>(ncid, varid, ec);
+    auto cft = parse_cf_time<typename T::clock, typename T::duration>(ncid, varid, ec);
     if (ec && ec->value())
         return result;
     
@@ -852,7 +859,7 @@ get_var1(int ncid, int varid, const index_type& start, std::error_code *ec = nul
         return result;
     
     std::chrono::duration<double> sec(offset * cft.scale);
-    result = cft.start + std::chrono::duration_cast<T::duration>(sec);
+    result = cft.start + std::chrono::duration_cast<typename T::duration>(sec);
     
     return result;
 }
@@ -863,7 +870,7 @@ get_var1(int ncid, int varid, const index_type& start, std::error_code *ec = nul
 template <class Container>
 Container get_var(int ncid, int varid, std::error_code *ec = nullptr)
 {   
-    count_type shape = get_varshape(ncid, varid, ec);
+    index_type shape = inq_varshape(ncid, varid, ec);
     index_type start(shape.size(), 0);
     stride_type stride(shape.size(), 1);
     return get_vars<Container>(ncid, varid, start, shape, stride, ec);
@@ -968,6 +975,10 @@ inline chunk_cache get_var_chunk_cache(int ncid, int varid, std::error_code &ec)
     { return impl::get_var_chunk_cache(ncid, varid, &ec); }
 inline chunk_cache get_var_chunk_cache(int ncid, int varid)
     { return impl::get_var_chunk_cache(ncid, varid); }
+inline void set_var_chunk_cache(int ncid, int varid, const chunk_cache& cache, std::error_code &ec)
+    { impl::set_var_chunk_cache(ncid, varid, cache, &ec); }
+inline void set_var_chunk_cache(int ncid, int varid, const chunk_cache& cache)
+    { impl::set_var_chunk_cache(ncid, varid, cache); }
 
 
 template <class Container>
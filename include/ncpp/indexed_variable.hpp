@@ -0,0 +1,337 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_INDEXED_VARIABLE_HPP
+#define NCPP_INDEXED_VARIABLE_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/detail/utilities.hpp>
+#include <ncpp/functions/ndarray.hpp>
+#include <ncpp/functions/variable.hpp>
+#include <ncpp/iterator.hpp>
+#include <ncpp/selection.hpp>
+#include <ncpp/variable.hpp>
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+
+/// Variable selection with a list of indexes for one or more dimensions.
+/// Indexes are relative to the selection of the underlying variable, and
+/// may be in any order or repeated.
+class indexed_variable
+{
+public:
+    explicit indexed_variable(variable v)
+        : var_(std::move(v))
+    {
+        const auto& shape = var_.shape();
+        indexes_.resize(shape.size());
+        for (std::size_t i = 0; i < shape.size(); ++i) {
+            indexes_[i].resize(shape[i]);
+            std::iota(indexes_[i].begin(), indexes_[i].end(), std::size_t(0));
+        }
+    }
+
+    /// Get the underlying variable.
+    const variable& base() const {
+        return var_;
+    }
+
+    /// Get the indexes for a dimension by position.
+    const index_type& indexes(std::size_t pos) const {
+        return indexes_.at(pos);
+    }
+
+    /// Get the shape of the data array.
+    index_type shape() const
+    {
+        index_type result;
+        result.reserve(indexes_.size());
+        for (const auto& index : indexes_)
+            result.push_back(index.size());
+        return result;
+    }
+
+    /// Get the total number of elements in the data array.
+    std::size_t size() const {
+        return api::compute_size(shape());
+    }
+
+    /// Select elements along a dimension by a list of indexes into the
+    /// current indexes for the dimension.
+    indexed_variable isel(const std::string& dimname, const index_type& indexes) const
+    {
+        auto n = var_.dims.position(dimname);
+        if (!n.has_value())
+            detail::throw_error(error::invalid_dimension);
+
+        indexed_variable v(*this);
+        const auto& current = indexes_[n.value()];
+        auto& index = v.indexes_[n.value()];
+        index.clear();
+        index.reserve(indexes.size());
+        for (const auto& i : indexes) {
+            if (i >= current.size())
+                detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+            index.push_back(current[i]);
+        }
+        return v;
+    }
+
+    /// Select elements along a dimension where a mask is true. The mask
+    /// length must match the current length of the dimension.
+    indexed_variable where(const std::string& dimname, const std::vector<bool>& mask) const
+    {
+        auto n = var_.dims.position(dimname);
+        if (!n.has_value())
+            detail::throw_error(error::invalid_dimension);
+        if (mask.size() != indexes_[n.value()].size())
+            detail::throw_error(error::invalid_dimension_size);
+
+        index_type indexes;
+        for (std::size_t i = 0; i < mask.size(); ++i) {
+            if (mask[i])
+                indexes.push_back(i);
+        }
+        return isel(dimname, indexes);
+    }
+
+    /// Copy values to allocated memory. Runs of indexes with a constant step
+    /// are coalesced into strided hyperslabs. Dense selections that would
+    /// need more hyperslabs than chunks are read chunk by chunk instead.
+    template <class T>
+    void read(T *out) const
+    {
+        const std::size_t ndims = indexes_.size();
+        std::vector<std::vector<run>> runs(ndims);
+        std::size_t nslabs = 1;
+        for (std::size_t d = 0; d < ndims; ++d) {
+            runs[d] = coalesce(indexes_[d]);
+            nslabs *= runs[d].size();
+        }
+
+        if (nslabs == 0)
+            return;
+
+        // Compare the number of reads for each method, and the fraction of
+        // the bounding box that is selected.
+        index_type lower(ndims), upper(ndims);
+        std::size_t nchunks = 1, bbox = 1;
+        if (nslabs > 1) {
+            index_type chunkshape = chunk_iterator::default_chunkshape(var_.ncid(), var_.varid());
+            for (std::size_t d = 0; d < ndims; ++d) {
+                const auto bounds = std::minmax_element(indexes_[d].begin(), indexes_[d].end());
+                lower[d] = *bounds.first;
+                upper[d] = *bounds.second;
+                nchunks *= api::compute_chunk_segments(var_.start()[d] + lower[d] * var_.stride()[d],
+                    upper[d] - lower[d] + 1, var_.stride()[d], std::max<std::size_t>(chunkshape[d], 1)).size();
+                bbox *= upper[d] - lower[d] + 1;
+            }
+        }
+
+        if (nslabs > nchunks && 2 * size() >= bbox)
+            read_chunks(out, lower, upper);
+        else
+            read_hyperslabs(out, runs);
+    }
+
+    /// Copy values to allocated memory with capacity for n elements.
+    template <class T>
+    void read(T *out, std::size_t n) const
+    {
+        if (n < size())
+            detail::throw_error(error::invalid_argument);
+        read(out);
+    }
+
+    /// Get values as std::vector.
+    template <class T, class A = std::allocator<T>>
+    std::vector<T, A> values() const
+    {
+        std::vector<T, A> result(size());
+        read(result.data());
+        return result;
+    }
+
+private:
+    // Run of indexes with a constant step, starting at a list position.
+    struct run
+    {
+        std::size_t position;
+        std::size_t count;
+        std::size_t first;
+        std::size_t step;
+    };
+
+    // Split a list of indexes into runs with a constant positive step.
+    static std::vector<run> coalesce(const index_type& indexes)
+    {
+        std::vector<run> runs;
+        for (std::size_t i = 0; i < indexes.size(); /**/) {
+            std::size_t j = i + 1;
+            std::size_t step = 1;
+            if (j < indexes.size() && indexes[j] > indexes[i]) {
+                step = indexes[j] - indexes[i];
+                while (j < indexes.size() && indexes[j] > indexes[j-1] && indexes[j] - indexes[j-1] == step)
+                    ++j;
+            }
+            runs.push_back(run{ i, j - i, indexes[i], step });
+            i = j;
+        }
+        return runs;
+    }
+
+    // Read one strided hyperslab for each combination of runs.
+    template <class T>
+    void read_hyperslabs(T *out, const std::vector<std::vector<run>>& runs) const
+    {
+        const std::size_t ndims = runs.size();
+        const index_type outshape = shape();
+        index_type start(ndims), count(ndims), position(ndims), k(ndims, 0);
+        stride_type stride(ndims);
+        std::vector<T> buffer;
+
+        for (;;) {
+            for (std::size_t d = 0; d < ndims; ++d) {
+                const auto& r = runs[d][k[d]];
+                start[d] = var_.start()[d] + r.first * static_cast<std::size_t>(var_.stride()[d]);
+                stride[d] = var_.stride()[d] * static_cast<std::ptrdiff_t>(r.step);
+                count[d] = r.count;
+                position[d] = r.position;
+            }
+
+            buffer.resize(api::compute_size(count));
+            check(api::impl::detail::get_vars(var_.ncid(), var_.varid(), start.data(), count.data(), stride.data(), buffer.data()));
+            api::for_each_row(position, count, outshape,
+                [&](std::size_t src, std::size_t dst, std::size_t n) {
+                    std::copy_n(buffer.data() + src, n, out + dst);
+                });
+
+            // Advance to the next combination of runs.
+            std::size_t d = ndims;
+            for (; d != 0; --d) {
+                if (++k[d-1] < runs[d-1].size())
+                    break;
+                k[d-1] = 0;
+            }
+            if (d == 0)
+                break;
+        }
+    }
+
+    // Read the bounding box of the indexes chunk by chunk, and copy the
+    // selected elements of each chunk.
+    template <class T>
+    void read_chunks(T *out, const index_type& lower, const index_type& upper) const
+    {
+        const std::size_t ndims = indexes_.size();
+        const index_type outshape = shape();
+
+        // Sort the list positions for each dimension by index.
+        std::vector<std::vector<std::pair<std::size_t, std::size_t>>> sorted(ndims);
+        index_type start(ndims), count(ndims);
+        for (std::size_t d = 0; d < ndims; ++d) {
+            for (std::size_t i = 0; i < indexes_[d].size(); ++i)
+                sorted[d].emplace_back(indexes_[d][i] - lower[d], i);
+            std::sort(sorted[d].begin(), sorted[d].end());
+            start[d] = var_.start()[d] + lower[d] * static_cast<std::size_t>(var_.stride()[d]);
+            count[d] = upper[d] - lower[d] + 1;
+        }
+
+        using entry_iterator = std::vector<std::pair<std::size_t, std::size_t>>::const_iterator;
+        std::vector<std::pair<entry_iterator, entry_iterator>> ranges(ndims);
+        std::vector<entry_iterator> k(ndims);
+        std::vector<T> buffer;
+
+        chunk_iterator it(var_.ncid(), var_.varid(), start, count, var_.stride());
+        while (it.next()) {
+            const index_type position = it.position();
+            const index_type blockcount = it.count();
+
+            // Find the selected elements within the block for each dimension.
+            bool empty = false;
+            for (std::size_t d = 0; d < ndims; ++d) {
+                auto first = std::lower_bound(sorted[d].cbegin(), sorted[d].cend(),
+                    std::make_pair(position[d], std::size_t(0)));
+                auto last = std::lower_bound(first, sorted[d].cend(),
+                    std::make_pair(position[d] + blockcount[d], std::size_t(0)));
+                ranges[d] = std::make_pair(first, last);
+                empty = empty || (first == last);
+                k[d] = first;
+            }
+            if (empty)
+                continue;
+
+            it.read(buffer);
+            for (;;) {
+                std::size_t src = 0, dst = 0;
+                for (std::size_t d = 0; d < ndims; ++d) {
+                    src = src * blockcount[d] + (k[d]->first - position[d]);
+                    dst = dst * outshape[d] + k[d]->second;
+                }
+                out[dst] = buffer[src];
+
+                std::size_t d = ndims;
+                for (; d != 0; --d) {
+                    if (++k[d-1] != ranges[d-1].second)
+                        break;
+                    k[d-1] = ranges[d-1].first;
+                }
+                if (d == 0)
+                    break;
+            }
+        }
+    }
+
+    variable var_;
+    std::vector<index_type> indexes_;
+};
+
+inline indexed_variable variable::isel(const std::string& dimname, const index_type& indexes) const
+{
+    return indexed_variable(*this).isel(dimname, indexes);
+}
+
+template <class... Ts>
+indexed_variable variable::select(nearest_selection<Ts>&&... selections) const
+{
+    indexed_variable v(*this);
+
+    // Index each dimension by the nearest coordinate positions.
+    auto tuple = std::make_tuple(std::forward<nearest_selection<Ts>>(selections)...);
+    detail::apply_index([&] (auto i, auto&& s) {
+        const auto& dim = dims.at(coordinate_position(s.coordinate));
+        v = v.isel(dim.name(), nearest(s.coordinate, s.values, s.tolerance));
+    }, tuple);
+
+    return v;
+}
+
+inline indexed_variable variable::where(const std::string& dimname, const std::vector<bool>& mask) const
+{
+    return indexed_variable(*this).where(dimname, mask);
+}
+
+} // namespace ncpp
+
+#endif // NCPP_INDEXED_VARIABLE_HPP
@@ -0,0 +1,419 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_IO_SERVICE_HPP
+#define NCPP_IO_SERVICE_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/detail/netcdf_lock.hpp>
+#include <ncpp/functions/ndarray.hpp>
+#include <ncpp/functions/variable.hpp>
+#include <ncpp/attribute.hpp>
+#include <ncpp/cancellation.hpp>
+#include <ncpp/selection.hpp>
+#include <ncpp/variable.hpp>
+#include <ncpp/check.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <system_error>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+namespace detail {
+
+// Queued hyperslab read, delivered through a promise.
+struct read_request
+{
+    read_request(const variable& v, std::type_index type, const cancellation& c)
+        : ncid(v.ncid()), varid(v.varid()), type(type),
+          start(v.start()), count(v.shape()), stride(v.stride()), cancel(c)
+    {}
+
+    virtual ~read_request() = default;
+
+    // Read the bounding hyperslab of a cluster of requests with the same
+    // variable and type as this one, and deliver each result.
+    virtual void read(const std::vector<read_request *>& cluster, const index_type& start, const index_type& count) = 0;
+
+    virtual void fail(std::exception_ptr e) = 0;
+
+    bool unit_stride() const {
+        return std::all_of(stride.begin(), stride.end(), [](std::ptrdiff_t s) { return s == 1; });
+    }
+
+    int ncid;
+    int varid;
+    std::type_index type;
+    index_type start;
+    index_type count;
+    stride_type stride;
+    cancellation cancel;
+};
+
+template <class T, class A>
+struct typed_read_request : read_request
+{
+    using result_type = std::vector<T, A>;
+    using callback_type = std::function<void(std::exception_ptr, result_type)>;
+
+    typed_read_request(const variable& v, const cancellation& c, callback_type f = nullptr)
+        : read_request(v, std::type_index(typeid(typed_read_request)), c), callback(std::move(f))
+    {}
+
+    void read(const std::vector<read_request *>& cluster, const index_type& bstart, const index_type& bcount) override
+    {
+        if (cluster.size() == 1) {
+            std::vector<T, A> result(api::compute_size(count));
+            {
+                netcdf_lock lock;
+                check(api::impl::detail::get_vars(ncid, varid, start.data(), count.data(), stride.data(), result.data()));
+            }
+            deliver(std::move(result));
+            return;
+        }
+
+        std::vector<T> buffer(api::compute_size(bcount));
+        const stride_type unit(bcount.size(), 1);
+        {
+            netcdf_lock lock;
+            check(api::impl::detail::get_vars(ncid, varid, bstart.data(), bcount.data(), unit.data(), buffer.data()));
+        }
+
+        // Copy each request from the bounding hyperslab.
+        for (auto *r : cluster) {
+            auto *t = static_cast<typed_read_request *>(r);
+            std::vector<T, A> result(api::compute_size(t->count));
+            index_type position(bcount.size());
+            for (std::size_t i = 0; i < position.size(); ++i)
+                position[i] = t->start[i] - bstart[i];
+            api::for_each_row(position, t->count, bcount,
+                [&](std::size_t dst, std::size_t src, std::size_t n) {
+                    std::copy_n(buffer.data() + src, n, result.data() + dst);
+                });
+            t->deliver(std::move(result));
+        }
+    }
+
+    // Requests of a cluster that were already delivered when a later
+    // request failed are skipped.
+    void fail(std::exception_ptr e) override
+    {
+        if (done)
+            return;
+        done = true;
+        if (callback)
+            invoke(e, result_type{});
+        else
+            promise.set_exception(e);
+    }
+
+    void deliver(result_type result)
+    {
+        done = true;
+        if (callback)
+            invoke(nullptr, std::move(result));
+        else
+            promise.set_value(std::move(result));
+    }
+
+    // The callback runs on the executor thread, which must not unwind.
+    void invoke(std::exception_ptr e, result_type result) noexcept
+    {
+        try {
+            callback(e, std::move(result));
+        }
+        catch (...) {
+        }
+    }
+
+    std::promise<result_type> promise;
+    callback_type callback;
+    bool done = false; // delivered or failed
+};
+
+} // namespace detail
+
+/// I/O service that runs netCDF-C calls on a dedicated executor thread,
+/// with a future-based API for use from any thread. Queued hyperslab reads
+/// of the same variable and type are batched, and reads that overlap or
+/// touch are coalesced into a single read of their bounding hyperslab.
+///
+/// Requests and posted tasks run while holding detail::netcdf_lock. Only
+/// calls made through the service are serialized this way: direct calls on
+/// other threads, such as variable::read, are not, and should be posted to
+/// the service instead while it is in use.
+class io_service
+{
+public:
+    io_service()
+        : thread_([this] { run(); })
+    {}
+
+    io_service(const io_service&) = delete;
+    io_service& operator=(const io_service&) = delete;
+
+    /// Queued requests are completed before the executor is joined.
+    ~io_service()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    /// Get the I/O service shared by the asynchronous variable methods.
+    static io_service& shared()
+    {
+        static io_service service;
+        return service;
+    }
+
+    /// Run a function on the executor thread, holding the netCDF-C lock.
+    /// The function must not wait for other futures of the same service,
+    /// which would never complete, or for thread pool tasks that take the
+    /// netCDF-C lock.
+    template <class F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> post(F&& f, const cancellation& c = cancellation())
+    {
+        using result_type = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<result_type()>>(
+            [f = std::forward<F>(f), c]() mutable {
+                c.throw_if_cancelled();
+                return f();
+            });
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace_back([task] { detail::netcdf_lock lock; (*task)(); });
+        }
+        cv_.notify_one();
+        return result;
+    }
+
+    /// Get the values of a variable selection.
+    template <class T, class A = std::allocator<T>>
+    std::future<std::vector<T, A>> values(const variable& v, const cancellation& c = cancellation())
+    {
+        auto request = std::make_unique<detail::typed_read_request<T, A>>(v, c);
+        auto result = request->promise.get_future();
+        push(std::move(request));
+        return result;
+    }
+
+    /// Get the values of a variable selection, then invoke a callback on the
+    /// executor thread with an exception pointer (null on success) and the
+    /// values. Exceptions thrown by the callback are ignored.
+    template <class T, class A = std::allocator<T>, class F,
+              class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, cancellation>>>
+    void values(const variable& v, F&& callback, const cancellation& c = cancellation())
+    {
+        push(std::make_unique<detail::typed_read_request<T, A>>(v, c, std::forward<F>(callback)));
+    }
+
+    /// Select a subset of a variable by coordinate range. Coordinate
+    /// variables are read on the executor thread.
+    template <class... Ts>
+    std::future<variable> select(const variable& v, selection<Ts>... selections)
+    {
+        return post([v, selections...]() mutable {
+            return v.select(std::move(selections)...);
+        });
+    }
+
+    /// Get the first value of an attribute.
+    template <class T>
+    std::future<T> value(const attribute& a)
+    {
+        return post([a] { return a.template value<T>(); });
+    }
+
+    /// Get the values of an attribute.
+    template <class T, class A = std::allocator<T>>
+    std::future<std::vector<T, A>> values(const attribute& a)
+    {
+        return post([a] { return a.template values<T, A>(); });
+    }
+
+private:
+    void push(std::unique_ptr<detail::read_request> request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reads_.push_back(std::move(request));
+        }
+        cv_.notify_one();
+    }
+
+    void run()
+    {
+        for (;;) {
+            std::vector<std::function<void()>> tasks;
+            std::vector<std::unique_ptr<detail::read_request>> reads;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopped_ || !tasks_.empty() || !reads_.empty(); });
+                if (tasks_.empty() && reads_.empty())
+                    return;
+                tasks.swap(tasks_);
+                reads.swap(reads_);
+            }
+
+            for (auto& task : tasks)
+                task();
+            dispatch(reads);
+        }
+    }
+
+    // Group reads by variable and type, then read each cluster of reads with
+    // overlapping or adjacent unit stride hyperslabs.
+    static void dispatch(std::vector<std::unique_ptr<detail::read_request>>& reads)
+    {
+        using key_type = std::tuple<int, int, std::type_index>;
+        std::map<key_type, std::vector<detail::read_request *>> groups;
+        for (auto& r : reads) {
+            if (r->cancel.is_cancelled())
+                r->fail(std::make_exception_ptr(std::system_error(std::make_error_code(std::errc::operation_canceled))));
+            else
+                groups[key_type(r->ncid, r->varid, r->type)].push_back(r.get());
+        }
+
+        struct cluster
+        {
+            std::vector<detail::read_request *> requests;
+            index_type start;
+            index_type end;
+            std::size_t volume;
+        };
+
+        for (auto& group : groups) {
+            std::vector<cluster> clusters;
+            for (auto *r : group.second) {
+                index_type end(r->start.size());
+                for (std::size_t i = 0; i < end.size(); ++i)
+                    end[i] = r->start[i] + r->count[i];
+                const std::size_t volume = api::compute_size(r->count);
+
+                bool merged = false;
+                for (auto& c : clusters) {
+                    if (!r->unit_stride())
+                        break;
+                    if (!c.requests.front()->unit_stride() || !mergeable(c.start, c.end, c.volume, r->start, end, volume))
+                        continue;
+                    for (std::size_t i = 0; i < end.size(); ++i) {
+                        c.start[i] = std::min(c.start[i], r->start[i]);
+                        c.end[i] = std::max(c.end[i], end[i]);
+                    }
+                    c.requests.push_back(r);
+                    c.volume += volume;
+                    merged = true;
+                    break;
+                }
+                if (!merged)
+                    clusters.push_back(cluster{ { r }, r->start, end, volume });
+            }
+
+            for (auto& c : clusters) {
+                index_type count(c.start.size());
+                for (std::size_t i = 0; i < count.size(); ++i)
+                    count[i] = c.end[i] - c.start[i];
+                try {
+                    c.requests.front()->read(c.requests, c.start, count);
+                }
+                catch (...) {
+                    for (auto *r : c.requests)
+                        r->fail(std::current_exception());
+                }
+            }
+        }
+    }
+
+    // Returns true if two hyperslabs overlap or touch in every dimension and
+    // their bounding hyperslab is at most twice the size of both.
+    static bool mergeable(const index_type& start0, const index_type& end0, std::size_t volume0,
+                          const index_type& start1, const index_type& end1, std::size_t volume1)
+    {
+        std::size_t volume = 1;
+        for (std::size_t i = 0; i < start0.size(); ++i) {
+            if (start1[i] > end0[i] || start0[i] > end1[i])
+                return false;
+            volume *= std::max(end0[i], end1[i]) - std::min(start0[i], start1[i]);
+        }
+        return volume <= 2 * (volume0 + volume1);
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::function<void()>> tasks_;
+    std::vector<std::unique_ptr<detail::read_request>> reads_;
+    bool stopped_ = false;
+    std::thread thread_;
+};
+
+template <class T, class A>
+std::future<std::vector<T, A>> variable::values_async(const cancellation& c) const
+{
+    return io_service::shared().values<T, A>(*this, c);
+}
+
+template <class T, class A, class F, class>
+void variable::values_async(F&& callback, const cancellation& c) const
+{
+    io_service::shared().values<T, A>(*this, std::forward<F>(callback), c);
+}
+
+template <class T>
+std::future<void> variable::read_async(T *out, const cancellation& c) const
+{
+    return io_service::shared().post([v = *this, out] { v.read(out); }, c);
+}
+
+template <class T>
+std::future<std::vector<T>> variable::coordinates_async(std::size_t pos, const cancellation& c) const
+{
+    return io_service::shared().post([v = *this, pos] { return v.coordinates<T>(pos); }, c);
+}
+
+#ifdef NCPP_USE_BOOST
+
+template <class T, std::size_t N, class A>
+std::future<variable::multi_array_type<T, N, A>> variable::multi_array_async(const cancellation& c) const
+{
+    return io_service::shared().post([v = *this] { return v.multi_array<T, N, A>(); }, c);
+}
+
+template <class T, class A>
+std::future<variable::matrix_type<T, A>> variable::matrix_async(const cancellation& c) const
+{
+    return io_service::shared().post([v = *this] { return v.matrix<T, A>(); }, c);
+}
+
+#endif // NCPP_USE_BOOST
+
+} // namespace ncpp
+
+#endif // NCPP_IO_SERVICE_HPP
@@ -16,11 +16,14 @@
 #include <ncpp/functions/dataset.hpp>
 #include <ncpp/functions/variable.hpp>
 #include <ncpp/functions/ndarray.hpp>
+#include <ncpp/check.hpp>
 #include <ncpp/error.hpp>
 #include <ncpp/types.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <iterator>
+#include <utility>
 #include <vector>
 
 namespace ncpp {
@@ -90,6 +93,13 @@ struct block_iterator
         return count_;
     }
 
+    /// Get the position of the current block relative to the first element
+    /// of the selection, such that ravel_index(position(), shape) is the
+    /// offset of the block.
+    index_type position() const {
+        return api::unravel_index(offset_ - blocksize_, shape_);
+    }
+
     /// Get the current block size (number of elements).
     std::size_t block_size() const {
         return blocksize_;
@@ -121,6 +131,34 @@ struct block_iterator
         return true;
     }
 
+    /// Copy values for the current block to allocated memory.
+    template <class T>
+    void read(T *out) const
+    {
+        const stride_type stride(shape_.size(), 1);
+        check(api::impl::detail::get_vars(ncid_, varid_, start_.data(), count_.data(), stride.data(), out));
+    }
+
+    /// Copy values for the current block to allocated memory with capacity
+    /// for n elements.
+    template <class T>
+    void read(T *out, std::size_t n) const
+    {
+        if (n < blocksize_)
+            detail::throw_error(error::invalid_argument);
+        read(out);
+    }
+
+    /// Copy values for the current block to a reused buffer. The buffer is
+    /// resized to the block size, which only allocates when it grows beyond
+    /// its capacity.
+    template <class T, class A>
+    void read(std::vector<T, A>& buffer) const
+    {
+        buffer.resize(blocksize_);
+        read(buffer.data());
+    }
+
     /// Get values as a std::vector.
     template <class T, class A = std::allocator<T>>
     std::vector<T, A> values() const
@@ -141,6 +179,166 @@ private:
     std::size_t init_blocksize_ = 0;
 };
 
+/// Iterator over the intersections of a strided hyperslab with the chunk
+/// grid of a variable, so that each chunk is read once per pass. Contiguous
+/// variables are split into tiles of at most NCPP_DEFAULT_BUFFER_SIZE bytes.
+struct chunk_iterator
+{
+    chunk_iterator(int ncid, int varid, const index_type& start, const index_type& shape, const stride_type& stride, const index_type& chunkshape)
+        : ncid_(ncid), varid_(varid), sel_start_(start), sel_stride_(stride),
+          start_(index_type(shape.size(), 0)), count_(index_type(shape.size(), 0)),
+          position_(index_type(shape.size(), 0)), index_(index_type(shape.size(), 0))
+    {
+        if (start.size() != shape.size() || stride.size() != shape.size() || chunkshape.size() != shape.size())
+            detail::throw_error(error::argument_out_of_domain); // NC_EEDGE
+
+        segments_.reserve(shape.size());
+        for (std::size_t i = 0; i < shape.size(); ++i) {
+            if (stride[i] <= 0)
+                detail::throw_error(error::illegal_stride); // NC_ESTRIDE
+            segments_.emplace_back(api::compute_chunk_segments(start[i], shape[i], stride[i],
+                std::max<std::size_t>(chunkshape[i], 1)));
+        }
+    }
+
+    chunk_iterator(int ncid, int varid, const index_type& start, const index_type& shape, const stride_type& stride)
+        : chunk_iterator(ncid, varid, start, shape, stride, default_chunkshape(ncid, varid))
+    {}
+
+    /// Get the number of elements read through the end of the current block.
+    std::size_t offset() const {
+        return offset_;
+    }
+
+    /// Get the start index for the current block.
+    index_type start() const {
+        return start_;
+    }
+
+    /// Get the counts (edge lengths) for the current block.
+    index_type count() const {
+        return count_;
+    }
+
+    /// Get the strides for the current block.
+    stride_type stride() const {
+        return sel_stride_;
+    }
+
+    /// Get the position of the current block within the selection.
+    index_type position() const {
+        return position_;
+    }
+
+    /// Get the current block size (number of elements).
+    std::size_t block_size() const {
+        return blocksize_;
+    }
+
+    // Move to the next block. Returns false when past the end.
+    bool next()
+    {
+        if (done_)
+            return false;
+
+        if (first_) {
+            first_ = false;
+            for (const auto& s : segments_) {
+                if (s.empty()) {
+                    done_ = true;
+                    return false;
+                }
+            }
+        }
+        else {
+            // Advance the chunk index in row-major order.
+            std::size_t i = segments_.size();
+            for (; i != 0; --i) {
+                if (++index_[i-1] < segments_[i-1].size())
+                    break;
+                index_[i-1] = 0;
+            }
+            if (i == 0) {
+                done_ = true;
+                return false;
+            }
+        }
+
+        blocksize_ = 1;
+        for (std::size_t i = 0; i < segments_.size(); ++i) {
+            const auto& segment = segments_[i][index_[i]];
+            position_[i] = segment.first;
+            count_[i] = segment.second;
+            start_[i] = sel_start_[i] + segment.first * static_cast<std::size_t>(sel_stride_[i]);
+            blocksize_ *= segment.second;
+        }
+
+        offset_ += blocksize_;
+        return true;
+    }
+
+    /// Copy values for the current block to allocated memory.
+    template <class T>
+    void read(T *out) const
+    {
+        check(api::impl::detail::get_vars(ncid_, varid_, start_.data(), count_.data(), sel_stride_.data(), out));
+    }
+
+    /// Copy values for the current block to allocated memory with capacity
+    /// for n elements.
+    template <class T>
+    void read(T *out, std::size_t n) const
+    {
+        if (n < blocksize_)
+            detail::throw_error(error::invalid_argument);
+        read(out);
+    }
+
+    /// Copy values for the current block to a reused buffer. The buffer is
+    /// resized to the block size, which only allocates when it grows beyond
+    /// its capacity.
+    template <class T, class A>
+    void read(std::vector<T, A>& buffer) const
+    {
+        buffer.resize(blocksize_);
+        read(buffer.data());
+    }
+
+    /// Get values as a std::vector.
+    template <class T, class A = std::allocator<T>>
+    std::vector<T, A> values() const
+    {
+        return api::get_vars<std::vector<T, A>>(ncid_, varid_, start_, count_, sel_stride_);
+    }
+
+    /// Get the chunk shape of a variable, or a tile shape with the default
+    /// buffer size for contiguous variables.
+    static index_type default_chunkshape(int ncid, int varid)
+    {
+        index_type chunkshape = api::inq_var_chunksizes(ncid, varid);
+        if (!chunkshape.empty())
+            return chunkshape;
+
+        std::size_t elemsize = api::inq_type_size(ncid, api::inq_vartype(ncid, varid));
+        return api::compute_tile_shape(NCPP_DEFAULT_BUFFER_SIZE / elemsize, api::inq_varshape(ncid, varid));
+    }
+
+private:
+    int ncid_;
+    int varid_;
+    index_type sel_start_;
+    stride_type sel_stride_;
+    index_type start_;
+    index_type count_;
+    index_type position_;
+    index_type index_;
+    std::vector<std::vector<std::pair<std::size_t, std::size_t>>> segments_;
+    std::size_t offset_ = 0;
+    std::size_t blocksize_ = 0;
+    bool first_ = true;
+    bool done_ = false;
+};
+
 } // namespace ncpp
 
 #endif // NCPP_ITERATOR_HPP
@@ -0,0 +1,97 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_MASK_HPP
+#define NCPP_MASK_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/detail/kernels.hpp>
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace ncpp {
+
+/// Valid data test from the CF _FillValue, missing_value, valid_min,
+/// valid_max and valid_range attributes. NaN is never valid.
+template <class T>
+struct value_mask
+{
+    std::optional<T> fill_value;
+    std::optional<T> missing_value;
+    std::optional<T> valid_min;
+    std::optional<T> valid_max;
+
+    /// Returns true if a value is valid.
+    bool is_valid(const T& x) const noexcept
+    {
+        unsigned char valid;
+        validate(&x, 1, &valid);
+        return valid != 0;
+    }
+
+    /// Test a range of values, writing 1 for valid values and 0 otherwise.
+    void validate(const T *in, std::size_t n, unsigned char *out) const noexcept
+    {
+        detail::validate(in, n, valid_min.value_or(lowest()), valid_max.value_or(highest()),
+            fill_value.value_or(T{}), fill_value.has_value(),
+            missing_value.value_or(T{}), missing_value.has_value(), out);
+    }
+
+private:
+    static constexpr T lowest() noexcept {
+        if constexpr (std::numeric_limits<T>::has_infinity)
+            return -std::numeric_limits<T>::infinity();
+        else
+            return std::numeric_limits<T>::lowest();
+    }
+
+    static constexpr T highest() noexcept {
+        if constexpr (std::numeric_limits<T>::has_infinity)
+            return std::numeric_limits<T>::infinity();
+        else
+            return std::numeric_limits<T>::max();
+    }
+};
+
+/// Values with a packed validity bitmap, one bit per value.
+template <class T, class A = std::allocator<T>>
+struct masked_array
+{
+    /// Values, including invalid values as stored.
+    std::vector<T, A> data;
+
+    /// Validity bitmap. Bit n % 64 of word n / 64 is set if value n is valid.
+    std::vector<std::uint64_t> valid;
+
+    /// Returns true if the value at a position is valid.
+    bool is_valid(std::size_t n) const {
+        return (valid[n / 64] >> (n % 64)) & 1;
+    }
+
+    /// Get the number of valid values.
+    std::size_t count() const
+    {
+        std::size_t n = 0;
+        for (const auto& word : valid)
+            n += std::bitset<64>(word).count();
+        return n;
+    }
+};
+
+} // namespace ncpp
+
+#endif // NCPP_MASK_HPP
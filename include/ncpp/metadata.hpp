@@ -0,0 +1,373 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_METADATA_HPP
+#define NCPP_METADATA_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <netcdf.h>
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/functions/attribute.hpp>
+#include <ncpp/functions/dataset.hpp>
+#include <ncpp/functions/dimension.hpp>
+#include <ncpp/functions/variable.hpp>
+#include <ncpp/spatial_index.hpp>
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+
+/// Values of a coordinate variable in ascending order, read once and cached
+/// by the dataset metadata.
+template <class T>
+struct coordinate_index
+{
+    /// Coordinate values in ascending order.
+    std::vector<T> values;
+
+    /// True if the values are reversed with respect to the file.
+    bool descending = false;
+
+    /// Get the value at a position in the file.
+    const T& at(std::size_t pos) const {
+        return descending ? values[values.size() - 1 - pos] : values[pos];
+    }
+};
+
+/// Snapshot of the dimensions, variables and attributes of a netCDF dataset,
+/// shared by the dimension, variable and attribute views. Dimensions are read
+/// when the dataset is opened; variable records, the variable name index and
+/// attribute tables are read on first access. All member functions may be
+/// called concurrently.
+class metadata
+{
+public:
+    /// Dimension metadata.
+    struct dimension_info
+    {
+        int dimid;
+        std::string name;
+        std::size_t length;
+        bool unlimited;
+        int cvarid; // coordinate variable ID, or -1
+    };
+
+    /// Variable metadata.
+    struct variable_info
+    {
+        int varid;
+        std::string name;
+        int type;
+        std::vector<int> dimids;
+        index_type shape;
+        int natts;
+    };
+
+    /// Attribute metadata.
+    struct attribute_info
+    {
+        std::string name;
+        int type;
+        std::size_t length;
+    };
+
+    explicit metadata(int ncid)
+        : ncid_(ncid)
+    {
+        auto dimids = api::inq_dimids(ncid);
+        auto unlimdims = api::inq_unlimdims(ncid);
+        std::sort(dimids.begin(), dimids.end());
+        dims_.reserve(dimids.size());
+        for (const auto& dimid : dimids) {
+            bool unlimited = std::find(unlimdims.begin(), unlimdims.end(), dimid) != unlimdims.end();
+            dims_.push_back({ dimid, api::inq_dimname(ncid, dimid), api::inq_dimlen(ncid, dimid), unlimited, -1 });
+        }
+
+        // Variable records are read on first access; only the IDs are listed.
+        auto varids = api::inq_varids(ncid);
+        std::sort(varids.begin(), varids.end());
+        vars_.resize(varids.size());
+        for (std::size_t i = 0; i < varids.size(); ++i)
+            vars_[i].varid = varids[i];
+        var_once_ = std::make_unique<std::once_flag[]>(vars_.size());
+
+        // Build the dimension name index. Keys refer to the names stored
+        // above, which are never modified after construction.
+        dim_index_.reserve(dims_.size());
+        for (std::size_t i = 0; i < dims_.size(); ++i)
+            dim_index_.emplace(dims_[i].name, i);
+
+        // Get the coordinate variable associated with each dimension, if any.
+        // See also: iscoordvar function in netcdf-c/ncdump/dumplib.c
+        for (auto& d : dims_) {
+            auto varid = api::inq_varid(ncid, d.name);
+            if (varid.has_value() && is_coordinate(var(varid.value()), d.dimid))
+                d.cvarid = varid.value();
+        }
+
+        atts_.resize(vars_.size() + 1);
+        att_index_.resize(vars_.size() + 1);
+        att_once_ = std::make_unique<std::once_flag[]>(vars_.size() + 1);
+    }
+
+    metadata(const metadata&) = delete;
+    metadata& operator=(const metadata&) = delete;
+
+    /// Get the netCDF ID.
+    int ncid() const {
+        return ncid_;
+    }
+
+    /// Get all dimensions, ordered by ID.
+    const std::vector<dimension_info>& dims() const {
+        return dims_;
+    }
+
+    /// Get the number of variables.
+    std::size_t nvars() const noexcept {
+        return vars_.size();
+    }
+
+    /// Get all variables, ordered by ID. Reads any records not yet loaded.
+    const std::vector<variable_info>& vars() const
+    {
+        for (std::size_t i = 0; i < vars_.size(); ++i)
+            load_var(i);
+        return vars_;
+    }
+
+    /// Get a dimension by ID.
+    const dimension_info& dim(int dimid) const
+    {
+        // IDs are usually contiguous from zero; otherwise use binary search.
+        if (dimid >= 0 && static_cast<std::size_t>(dimid) < dims_.size() && dims_[dimid].dimid == dimid)
+            return dims_[dimid];
+
+        auto it = std::lower_bound(dims_.begin(), dims_.end(), dimid,
+            [](const auto& d, int id) { return d.dimid < id; });
+        if (it == dims_.end() || it->dimid != dimid)
+            detail::throw_error(error::invalid_dimension);
+        return *it;
+    }
+
+    /// Get the ID of the variable at a position, ordered by ID.
+    int varid(std::size_t n) const noexcept {
+        return vars_[n].varid;
+    }
+
+    /// Get a variable by ID. The record is read on first access.
+    const variable_info& var(int varid) const
+    {
+        return load_var(var_position(varid));
+    }
+
+    /// Get the ID of a variable from its name. The name index is built on
+    /// first access.
+    std::optional<int> find_var(std::string_view name) const
+    {
+        std::call_once(var_index_once_, [this] {
+            // Build into locals so that a failure leaves no partial index.
+            // Moving the vector keeps the strings, and so the keys, in place.
+            std::vector<std::string> names(vars_.size());
+            std::unordered_map<std::string_view, std::size_t> index;
+            index.reserve(vars_.size());
+            for (std::size_t i = 0; i < vars_.size(); ++i) {
+                names[i] = api::inq_varname(ncid_, vars_[i].varid);
+                index.emplace(names[i], i);
+            }
+            var_names_ = std::move(names);
+            var_index_ = std::move(index);
+        });
+
+        auto it = var_index_.find(name);
+        if (it == var_index_.end())
+            return std::nullopt;
+        return vars_[it->second].varid;
+    }
+
+    /// Get the ID of a dimension from its name.
+    std::optional<int> find_dim(std::string_view name) const noexcept
+    {
+        auto it = dim_index_.find(name);
+        if (it == dim_index_.end())
+            return std::nullopt;
+        return dims_[it->second].dimid;
+    }
+
+    /// Get the attributes of a variable, or NC_GLOBAL for global attributes.
+    /// Attributes are read on first access.
+    const std::vector<attribute_info>& atts(int varid) const
+    {
+        return atts_[load_atts(varid)];
+    }
+
+    /// Get an attribute of a variable by name.
+    const attribute_info *find_att(int varid, std::string_view name) const
+    {
+        std::size_t pos = load_atts(varid);
+        auto it = att_index_[pos].find(name);
+        return (it == att_index_[pos].end()) ? nullptr : &atts_[pos][it->second];
+    }
+
+    /// Get the cached index for a coordinate variable with value type T. The
+    /// values are read on first access.
+    template <class T>
+    const coordinate_index<T>& coordinates(int cvarid) const
+    {
+        const auto key = std::make_pair(cvarid, std::type_index(typeid(T)));
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto it = coords_.find(key);
+        if (it == coords_.end()) {
+            const auto& shape = var(cvarid).shape;
+            const index_type start(shape.size(), 0);
+            const stride_type stride(shape.size(), 1);
+
+            auto index = std::make_shared<coordinate_index<T>>();
+            index->values = api::get_vars<std::vector<T>>(ncid_, cvarid, start, shape, stride);
+
+            // Handle decreasing values.
+            if (!std::is_sorted(index->values.begin(), index->values.end())) {
+                std::reverse(index->values.begin(), index->values.end());
+                index->descending = true;
+            }
+
+            it = coords_.emplace(key, std::move(index)).first;
+        }
+        return *static_cast<const coordinate_index<T> *>(it->second.get());
+    }
+
+    /// Get the cached spatial index for two-dimensional latitude and
+    /// longitude variables with the same dimensions. The values are read on
+    /// first access.
+    const spatial_index& spatial(int latid, int lonid) const
+    {
+        const auto key = std::make_pair(latid, lonid);
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto it = spatial_.find(key);
+        if (it == spatial_.end()) {
+            const auto& lat = var(latid);
+            const auto& lon = var(lonid);
+            if (lat.dimids.size() != 2 || lat.dimids != lon.dimids)
+                detail::throw_error(error::invalid_dimension_size);
+
+            const index_type start(2, 0);
+            const stride_type stride(2, 1);
+            auto index = std::make_shared<const spatial_index>(
+                api::get_vars<std::vector<double>>(ncid_, latid, start, lat.shape, stride),
+                api::get_vars<std::vector<double>>(ncid_, lonid, start, lon.shape, stride),
+                lat.shape);
+
+            it = spatial_.emplace(key, std::move(index)).first;
+        }
+        return *it->second;
+    }
+
+    /// Returns true if the variable can be used as the coordinate variable
+    /// for a dimension: one-dimensional (two-dimensional for classic strings)
+    /// and indexed by the dimension.
+    static bool is_coordinate(const variable_info& var, int dimid) noexcept
+    {
+        if ((var.type != NC_CHAR && var.dimids.size() != 1) ||
+            (var.type == NC_CHAR && (var.dimids.empty() || var.dimids.size() > 2)))
+            return false;
+        return var.dimids.front() == dimid;
+    }
+
+private:
+    // Read a variable record on first access. Returns the record.
+    const variable_info& load_var(std::size_t pos) const
+    {
+        std::call_once(var_once_[pos], [this, pos] {
+            auto& var = vars_[pos];
+            var.name = api::inq_varname(ncid_, var.varid);
+            var.type = api::inq_vartype(ncid_, var.varid);
+            var.dimids = api::inq_vardimid(ncid_, var.varid);
+            var.natts = api::inq_varnatts(ncid_, var.varid);
+            var.shape.reserve(var.dimids.size());
+            for (const auto& dimid : var.dimids)
+                var.shape.push_back(dim(dimid).length);
+        });
+        return vars_[pos];
+    }
+
+    // Read the attribute table and build its name index on first access.
+    // Returns the table position.
+    std::size_t load_atts(int varid) const
+    {
+        std::size_t pos = (varid == NC_GLOBAL) ? 0 : var_position(varid) + 1;
+        std::call_once(att_once_[pos], [this, varid, pos] {
+            auto& atts = atts_[pos];
+            int natts = api::inq_varnatts(ncid_, varid);
+            atts.reserve(static_cast<std::size_t>(natts));
+            for (int attnum = 0; attnum < natts; ++attnum) {
+                std::string attname = api::inq_attname(ncid_, varid, attnum);
+                int atttype = api::inq_atttype(ncid_, varid, attname);
+                std::size_t attlen = api::inq_attlen(ncid_, varid, attname);
+                atts.push_back({ std::move(attname), atttype, attlen });
+            }
+            auto& index = att_index_[pos];
+            index.reserve(atts.size());
+            for (std::size_t i = 0; i < atts.size(); ++i)
+                index.emplace(atts[i].name, i);
+        });
+        return pos;
+    }
+
+    std::size_t var_position(int varid) const
+    {
+        if (varid >= 0 && static_cast<std::size_t>(varid) < vars_.size() && vars_[varid].varid == varid)
+            return static_cast<std::size_t>(varid);
+
+        auto it = std::lower_bound(vars_.begin(), vars_.end(), varid,
+            [](const auto& v, int id) { return v.varid < id; });
+        if (it == vars_.end() || it->varid != varid)
+            detail::throw_error(error::variable_not_found);
+        return static_cast<std::size_t>(std::distance(vars_.begin(), it));
+    }
+
+    int ncid_;
+    std::vector<dimension_info> dims_;
+    std::unordered_map<std::string_view, std::size_t> dim_index_;
+
+    // Lazily loaded tables. Each slot is written once, under its flag.
+    mutable std::vector<variable_info> vars_;
+    mutable std::unique_ptr<std::once_flag[]> var_once_;
+    mutable std::vector<std::string> var_names_;
+    mutable std::unordered_map<std::string_view, std::size_t> var_index_;
+    mutable std::once_flag var_index_once_;
+    mutable std::vector<std::vector<attribute_info>> atts_;
+    mutable std::vector<std::unordered_map<std::string_view, std::size_t>> att_index_;
+    mutable std::unique_ptr<std::once_flag[]> att_once_;
+
+    // Coordinate caches, guarded by mutex_.
+    mutable std::mutex mutex_;
+    mutable std::map<std::pair<int, std::type_index>, std::shared_ptr<const void>> coords_;
+    mutable std::map<std::pair<int, int>, std::shared_ptr<const spatial_index>> spatial_;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_METADATA_HPP
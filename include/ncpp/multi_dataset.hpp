@@ -0,0 +1,542 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_MULTI_DATASET_HPP
+#define NCPP_MULTI_DATASET_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <netcdf.h>
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/detail/netcdf_lock.hpp>
+#include <ncpp/functions/ndarray.hpp>
+#include <ncpp/functions/variable.hpp>
+#include <ncpp/file.hpp>
+#include <ncpp/metadata.hpp>
+#include <ncpp/process_pool.hpp>
+#include <ncpp/selection.hpp>
+#include <ncpp/variable.hpp>
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+namespace detail {
+
+// Open file with its metadata snapshot. Readers hold a reference while
+// reading, so evicting a file from the pool never closes it mid-read.
+struct pooled_file
+{
+    explicit pooled_file(const std::filesystem::path& path)
+        : f(path), meta(std::make_shared<const metadata>(f.ncid()))
+    {}
+
+    file f;
+    std::shared_ptr<const metadata> meta;
+};
+
+// Shared state of a multi-file dataset: the file list, the length of the
+// concatenated dimension in each file, and the pool of open files.
+class aggregation
+{
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    aggregation(std::vector<std::filesystem::path> paths, std::string dimname,
+                std::vector<std::size_t> lengths, std::size_t max_open)
+        : paths_(std::move(paths)), dimname_(std::move(dimname)),
+          lengths_(std::move(lengths)), offsets_(1, 0), max_open_(std::max<std::size_t>(max_open, 1))
+    {
+        if (paths_.empty())
+            detail::throw_error(error::invalid_argument);
+        if (lengths_.empty())
+            lengths_.assign(paths_.size(), npos);
+        if (lengths_.size() != paths_.size())
+            detail::throw_error(error::invalid_argument);
+    }
+
+    aggregation(const aggregation&) = delete;
+    aggregation& operator=(const aggregation&) = delete;
+
+    const std::filesystem::path& path(std::size_t pos) const {
+        return paths_.at(pos);
+    }
+
+    const std::string& dimname() const noexcept {
+        return dimname_;
+    }
+
+    std::size_t size() const noexcept {
+        return paths_.size();
+    }
+
+    // Get an open file. The least recently used file is closed if the pool
+    // is full. Callers hold the netCDF-C lock while using and releasing the
+    // file, which may be the last reference.
+    std::shared_ptr<const pooled_file> open(std::size_t pos)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return open_locked(pos);
+    }
+
+    // Get the length of the concatenated dimension in a file. This and the
+    // following functions may open and close files, so they take the
+    // netCDF-C lock before the pool mutex, in the same order as readers.
+    std::size_t length(std::size_t pos)
+    {
+        netcdf_lock guard;
+        std::lock_guard<std::mutex> lock(mutex_);
+        return length_locked(pos);
+    }
+
+    // Get the offset of a file along the concatenated dimension. The offset
+    // of size() is the total length. Lengths that were not passed to the
+    // constructor are read by opening the files in order.
+    std::size_t offset(std::size_t pos)
+    {
+        netcdf_lock guard;
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (offsets_.size() <= pos)
+            offsets_.push_back(offsets_.back() + length_locked(offsets_.size() - 1));
+        return offsets_[pos];
+    }
+
+    // Get the position of the file containing an index along the
+    // concatenated dimension.
+    std::size_t locate(std::size_t index)
+    {
+        netcdf_lock guard;
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (offsets_.back() <= index && offsets_.size() <= paths_.size())
+            offsets_.push_back(offsets_.back() + length_locked(offsets_.size() - 1));
+        if (offsets_.back() <= index)
+            detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+
+        auto it = std::upper_bound(offsets_.begin(), offsets_.end(), index);
+        return static_cast<std::size_t>(std::distance(offsets_.begin(), it)) - 1;
+    }
+
+private:
+    std::shared_ptr<const pooled_file> open_locked(std::size_t pos)
+    {
+        auto it = open_.find(pos);
+        if (it != open_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->second;
+        }
+
+        auto f = std::make_shared<const pooled_file>(paths_.at(pos));
+        if (lengths_[pos] == npos) {
+            auto dimid = f->meta->find_dim(dimname_);
+            if (!dimid.has_value())
+                detail::throw_error(error::invalid_dimension);
+            lengths_[pos] = f->meta->dim(dimid.value()).length;
+        }
+
+        lru_.emplace_front(pos, f);
+        open_[pos] = lru_.begin();
+        if (lru_.size() > max_open_) {
+            open_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+        return f;
+    }
+
+    std::size_t length_locked(std::size_t pos)
+    {
+        if (lengths_.at(pos) == npos)
+            open_locked(pos);
+        return lengths_[pos];
+    }
+
+    std::mutex mutex_;
+    std::vector<std::filesystem::path> paths_;
+    std::string dimname_;
+    std::vector<std::size_t> lengths_;
+    std::vector<std::size_t> offsets_;
+    std::size_t max_open_;
+    std::list<std::pair<std::size_t, std::shared_ptr<const pooled_file>>> lru_;
+    std::unordered_map<std::size_t, decltype(lru_)::iterator> open_;
+};
+
+} // namespace detail
+
+/// Variable of a multi-file dataset, with a hyperslab selection in which
+/// indexes along the concatenated dimension are global. Reads only open
+/// the files that overlap the selection.
+class multi_variable
+{
+public:
+    multi_variable(std::shared_ptr<detail::aggregation> agg, const std::string& name)
+        : agg_(std::move(agg)), name_(name)
+    {
+        detail::netcdf_lock lock;
+        const auto f = agg_->open(0);
+        const variable v = file_variable(*f);
+        start_ = v.start();
+        shape_ = v.shape();
+        stride_ = v.stride();
+
+        dimpos_ = 0;
+        for (const auto& dim : v.dims) {
+            if (dim.name() == agg_->dimname())
+                break;
+            ++dimpos_;
+        }
+        to_end_ = (dimpos_ < shape_.size());
+    }
+
+    /// Get the variable name.
+    const std::string& name() const {
+        return name_;
+    }
+
+    /// Returns true if the variable has the concatenated dimension.
+    bool is_aggregated() const noexcept {
+        return dimpos_ < shape_.size();
+    }
+
+    /// Get the shape of the selection. If the selection extends to the end
+    /// of the concatenated dimension, this opens any files whose lengths are
+    /// not known.
+    index_type shape() const
+    {
+        index_type result(shape_);
+        if (to_end_) {
+            const std::size_t total = agg_->offset(agg_->size());
+            const std::size_t stride = static_cast<std::size_t>(stride_[dimpos_]);
+            result[dimpos_] = (total > start_[dimpos_]) ? (total - start_[dimpos_] + stride - 1) / stride : 0;
+        }
+        return result;
+    }
+
+    /// Get the total number of elements in the selection.
+    std::size_t size() const {
+        return api::compute_size(shape());
+    }
+
+    /// Select a range of global indexes along the concatenated dimension.
+    multi_variable slice(std::size_t start, std::size_t count, std::ptrdiff_t stride = 1) const
+    {
+        if (!is_aggregated())
+            detail::throw_error(error::invalid_dimension);
+        if (stride < 1)
+            detail::throw_error(error::illegal_stride);
+
+        multi_variable v(*this);
+        v.start_[dimpos_] = start;
+        v.shape_[dimpos_] = count;
+        v.stride_[dimpos_] = stride;
+        v.to_end_ = false;
+        return v;
+    }
+
+    /// \group select
+    /// Select a subset by coordinate range. Coordinates of the concatenated
+    /// dimension must increase across files; the files are searched with a
+    /// binary search on their first and last values.
+    template <class T>
+    multi_variable select(selection<T> s) const
+    {
+        if (s.stride == 0)
+            detail::throw_error(error::illegal_stride);
+        if (s.min_value > s.max_value)
+            std::swap(s.min_value, s.max_value);
+
+        detail::netcdf_lock lock;
+        const auto f = agg_->open(0);
+        variable v = file_variable(*f);
+        const std::size_t pos = v.coordinate_position(s.coordinate);
+
+        multi_variable result(*this);
+        if (pos != dimpos_) {
+            // Coordinates of other dimensions are the same in every file.
+            v = v.select(s);
+            result.start_[pos] = v.start()[pos];
+            result.shape_[pos] = v.shape()[pos];
+            result.stride_[pos] = v.stride()[pos];
+            return result;
+        }
+
+        const std::size_t lower = bound(s.coordinate, s.min_value, false);
+        const std::size_t upper = bound(s.coordinate, s.max_value, true);
+        const std::size_t stride = static_cast<std::size_t>(std::abs(s.stride));
+        result.start_[dimpos_] = lower;
+        result.shape_[dimpos_] = (upper > lower) ? (upper - lower + stride - 1) / stride : 0;
+        result.stride_[dimpos_] = static_cast<std::ptrdiff_t>(stride);
+        result.to_end_ = false;
+        return result;
+    }
+
+    /// Copy values to allocated memory.
+    template <class T>
+    void read(T *out) const
+    {
+        const index_type outshape = shape();
+        for (const auto& r : plan(outshape))
+            read_file(r, outshape, out);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    /// Copy values to allocated memory, reading the files concurrently in
+    /// the worker processes of a reader pool. netCDF-C calls within one
+    /// process are serialized, so threads would not overlap the reads.
+    template <class T>
+    void read(T *out, process_pool& pool) const
+    {
+        const index_type outshape = shape();
+        const auto reads = plan(outshape);
+
+        std::vector<std::future<shared_array<T>>> pending;
+        pending.reserve(reads.size());
+        for (const auto& r : reads)
+            pending.push_back(pool.read<T>(agg_->path(r.pos), name_, r.start, r.count, stride_));
+
+        for (std::size_t i = 0; i < reads.size(); ++i) {
+            const auto values = pending[i].get();
+            api::for_each_row(reads[i].position, reads[i].count, outshape,
+                [&](std::size_t src, std::size_t dst, std::size_t n) {
+                    std::copy_n(values.data() + src, n, out + dst);
+                });
+        }
+    }
+#endif // defined(__unix__) || defined(__APPLE__)
+
+    /// Get values as std::vector.
+    template <class T, class A = std::allocator<T>>
+    std::vector<T, A> values() const
+    {
+        std::vector<T, A> result(size());
+        read(result.data());
+        return result;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    /// Get values as std::vector, reading the files concurrently in the
+    /// worker processes of a reader pool.
+    template <class T, class A = std::allocator<T>>
+    std::vector<T, A> values(process_pool& pool) const
+    {
+        std::vector<T, A> result(size());
+        read(result.data(), pool);
+        return result;
+    }
+#endif // defined(__unix__) || defined(__APPLE__)
+
+private:
+    // Read of the selection from one file.
+    struct file_read
+    {
+        std::size_t pos;
+        index_type start;     // start in the file
+        index_type count;     // count in the file
+        index_type position;  // position in the output
+    };
+
+    // Split the selection into one read for each overlapping file.
+    std::vector<file_read> plan(const index_type& outshape) const
+    {
+        std::vector<file_read> result;
+        if (api::compute_size(outshape) == 0)
+            return result;
+
+        if (!is_aggregated()) {
+            result.push_back(file_read{ 0, start_, outshape, index_type(outshape.size(), 0) });
+            return result;
+        }
+
+        const std::size_t first = start_[dimpos_];
+        const std::size_t count = outshape[dimpos_];
+        const std::size_t stride = static_cast<std::size_t>(stride_[dimpos_]);
+        std::size_t done = 0;
+
+        for (std::size_t pos = agg_->locate(first); pos < agg_->size() && done < count; ++pos) {
+            // Range of selected indexes within this file.
+            const std::size_t offset = agg_->offset(pos);
+            const std::size_t end = offset + agg_->length(pos);
+            const std::size_t k0 = (offset > first) ? (offset - first + stride - 1) / stride : 0;
+            const std::size_t k1 = std::min(count, (end > first) ? (end - first + stride - 1) / stride : 0);
+            if (k0 >= k1)
+                continue;
+
+            file_read r{ pos, start_, outshape, index_type(outshape.size(), 0) };
+            r.start[dimpos_] = first + k0 * stride - offset;
+            r.count[dimpos_] = k1 - k0;
+            r.position[dimpos_] = k0;
+            result.push_back(std::move(r));
+            done = k1;
+        }
+
+        if (done < count)
+            detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+        return result;
+    }
+
+    template <class T>
+    void read_file(const file_read& r, const index_type& outshape, T *out) const
+    {
+        if (is_aggregated() && dimpos_ != 0) {
+            std::vector<T> buffer(api::compute_size(r.count));
+            {
+                detail::netcdf_lock lock;
+                const auto f = agg_->open(r.pos);
+                check(api::impl::detail::get_vars(f->f.ncid(), varid(*f), r.start.data(), r.count.data(), stride_.data(), buffer.data()));
+            }
+            api::for_each_row(r.position, r.count, outshape,
+                [&](std::size_t src, std::size_t dst, std::size_t n) {
+                    std::copy_n(buffer.data() + src, n, out + dst);
+                });
+        }
+        else {
+            // Rows of the outer dimension are contiguous in the output.
+            T *dst = is_aggregated() ? out + r.position[0] * (api::compute_size(outshape) / outshape[0]) : out;
+            detail::netcdf_lock lock;
+            const auto f = agg_->open(r.pos);
+            check(api::impl::detail::get_vars(f->f.ncid(), varid(*f), r.start.data(), r.count.data(), stride_.data(), dst));
+        }
+    }
+
+    int varid(const detail::pooled_file& f) const
+    {
+        auto id = f.meta->find_var(name_);
+        if (!id.has_value())
+            detail::throw_error(error::variable_not_found);
+        return id.value();
+    }
+
+    variable file_variable(const detail::pooled_file& f) const {
+        return variable(f.meta, varid(f));
+    }
+
+    // Get the first global index with a coordinate value not less than
+    // (greater than, if upper) a value.
+    template <class T>
+    std::size_t bound(const std::string& coordvarname, const T& value, bool upper) const
+    {
+        auto before = [&](const T& x) { return upper ? !(value < x) : (x < value); };
+        detail::netcdf_lock lock;
+
+        // Find the first file with a value that is not before the bound.
+        std::size_t lo = 0, hi = agg_->size();
+        while (lo < hi) {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            const auto f = agg_->open(mid);
+            const auto& values = coordinates<T>(*f, coordvarname);
+            if (values.empty() || before(values.back()))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if (lo == agg_->size())
+            return agg_->offset(lo);
+
+        const auto f = agg_->open(lo);
+        const auto& values = coordinates<T>(*f, coordvarname);
+        auto it = upper ? std::upper_bound(values.begin(), values.end(), value)
+                        : std::lower_bound(values.begin(), values.end(), value);
+        return agg_->offset(lo) + static_cast<std::size_t>(std::distance(values.begin(), it));
+    }
+
+    // Get the cached coordinate values of a file, in ascending order.
+    template <class T>
+    static const std::vector<T>& coordinates(const detail::pooled_file& f, const std::string& coordvarname)
+    {
+        auto cvarid = f.meta->find_var(coordvarname);
+        if (!cvarid.has_value())
+            detail::throw_error(error::variable_not_found);
+        const auto& index = f.meta->coordinates<T>(cvarid.value());
+        if (index.descending)
+            detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+        return index.values;
+    }
+
+    std::shared_ptr<detail::aggregation> agg_;
+    std::string name_;
+    std::size_t dimpos_ = 0;
+    bool to_end_ = false;
+    index_type start_;
+    index_type shape_;
+    stride_type stride_;
+};
+
+/// Dataset of files concatenated along a shared dimension, typically the
+/// unlimited time dimension. Files are opened on first use and kept in a
+/// bounded pool, closing the least recently used file when the pool is
+/// full. Other dimensions and variable definitions must match in every
+/// file.
+class multi_dataset
+{
+public:
+    /// Lengths of the shared dimension are read by opening files in order
+    /// as needed.
+    multi_dataset(std::vector<std::filesystem::path> paths, const std::string& dimname,
+                  std::size_t max_open = NCPP_DEFAULT_MAX_OPEN_FILES)
+        : multi_dataset(std::move(paths), dimname, {}, max_open)
+    {}
+
+    /// Lengths of the shared dimension are known for each file, so no files
+    /// are opened to locate an index.
+    multi_dataset(std::vector<std::filesystem::path> paths, const std::string& dimname,
+                  std::vector<std::size_t> lengths, std::size_t max_open = NCPP_DEFAULT_MAX_OPEN_FILES)
+        : agg_(std::make_shared<detail::aggregation>(std::move(paths), dimname, std::move(lengths), max_open))
+    {}
+
+    /// Get the number of files.
+    std::size_t size() const noexcept {
+        return agg_->size();
+    }
+
+    /// Get the path to a file.
+    const std::filesystem::path& path(std::size_t pos) const {
+        return agg_->path(pos);
+    }
+
+    /// Get the name of the shared dimension.
+    const std::string& dimension_name() const noexcept {
+        return agg_->dimname();
+    }
+
+    /// Get the total length of the shared dimension.
+    std::size_t length() const {
+        return agg_->offset(agg_->size());
+    }
+
+    /// Get the position of the file containing a global index along the
+    /// shared dimension.
+    std::size_t locate(std::size_t index) const {
+        return agg_->locate(index);
+    }
+
+    /// Get a variable by name. Opens the first file for the definition.
+    multi_variable var(const std::string& name) const {
+        return multi_variable(agg_, name);
+    }
+
+private:
+    std::shared_ptr<detail::aggregation> agg_;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_MULTI_DATASET_HPP
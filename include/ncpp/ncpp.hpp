@@ -18,10 +18,17 @@
 #include <ncpp/error.hpp>
 #include <ncpp/file.hpp>
 #include <ncpp/dataset.hpp>
+#include <ncpp/metadata.hpp>
+#include <ncpp/multi_dataset.hpp>
 #include <ncpp/dimensions.hpp>
 #include <ncpp/variables.hpp>
 #include <ncpp/attributes.hpp>
 #include <ncpp/iterator.hpp>
+#include <ncpp/mask.hpp>
+#include <ncpp/block_reader.hpp>
+#include <ncpp/thread_pool.hpp>
+#include <ncpp/io_service.hpp>
+#include <ncpp/access_planner.hpp>
 
 #include <ncpp/functions/attribute.hpp>
 #include <ncpp/functions/dataset.hpp>
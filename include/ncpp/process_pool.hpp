@@ -0,0 +1,523 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_PROCESS_POOL_HPP
+#define NCPP_PROCESS_POOL_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <netcdf.h>
+
+#include <ncpp/config.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <ncpp/functions/ndarray.hpp>
+#include <ncpp/functions/variable.hpp>
+#include <ncpp/file.hpp>
+#include <ncpp/variable.hpp>
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+#include <ncpp/types.hpp>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+
+/// Array in a shared memory segment mapped into this process, as returned
+/// by a worker process. The segment is unmapped on destruction.
+template <class T>
+class shared_array
+{
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    shared_array() = default;
+
+    shared_array(void *addr, std::size_t n)
+        : data_(static_cast<T *>(addr)), size_(n)
+    {}
+
+    shared_array(const shared_array&) = delete;
+    shared_array& operator=(const shared_array&) = delete;
+
+    shared_array(shared_array&& rhs) noexcept
+        : data_(std::exchange(rhs.data_, nullptr)), size_(std::exchange(rhs.size_, 0))
+    {}
+
+    shared_array& operator=(shared_array&& rhs) noexcept
+    {
+        if (this != &rhs) {
+            reset();
+            data_ = std::exchange(rhs.data_, nullptr);
+            size_ = std::exchange(rhs.size_, 0);
+        }
+        return *this;
+    }
+
+    ~shared_array() {
+        reset();
+    }
+
+    T *data() noexcept { return data_; }
+    const T *data() const noexcept { return data_; }
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+    T& operator[](size_type n) noexcept { return data_[n]; }
+    const T& operator[](size_type n) const noexcept { return data_[n]; }
+
+private:
+    void reset() noexcept
+    {
+        if (data_)
+            ::munmap(data_, size_ * sizeof(T));
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    T *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+namespace detail {
+
+// Request sent to a worker process, followed by the path, the variable
+// name, and the start, count and stride arrays.
+struct process_request
+{
+    std::uint32_t path_size;
+    std::uint32_t name_size;
+    std::uint32_t type;
+    std::uint32_t ndims;
+};
+
+// Reply from a worker process, followed by the shared memory segment name.
+struct process_reply
+{
+    std::int32_t error;      // error value, or zero
+    std::int32_t generic;    // nonzero if error is an errno value
+    std::uint64_t size;      // number of elements
+    std::uint32_t name_size;
+};
+
+// Element type codes for the request.
+template <class T>
+constexpr std::uint32_t process_type()
+{
+    if constexpr (std::is_same_v<T, char>) return 1;
+    else if constexpr (std::is_same_v<T, signed char>) return 2;
+    else if constexpr (std::is_same_v<T, unsigned char>) return 3;
+    else if constexpr (std::is_same_v<T, short>) return 4;
+    else if constexpr (std::is_same_v<T, unsigned short>) return 5;
+    else if constexpr (std::is_same_v<T, int>) return 6;
+    else if constexpr (std::is_same_v<T, unsigned int>) return 7;
+    else if constexpr (std::is_same_v<T, long long>) return 8;
+    else if constexpr (std::is_same_v<T, unsigned long long>) return 9;
+    else if constexpr (std::is_same_v<T, float>) return 10;
+    else if constexpr (std::is_same_v<T, double>) return 11;
+    else return 0;
+}
+
+inline void write_all(int fd, const void *buf, std::size_t n)
+{
+#if defined(MSG_NOSIGNAL)
+    constexpr int flags = MSG_NOSIGNAL;
+#else
+    constexpr int flags = 0;
+#endif
+    const char *p = static_cast<const char *>(buf);
+    while (n > 0) {
+        ssize_t rc = ::send(fd, p, n, flags);
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc <= 0)
+            throw std::system_error(errno ? errno : EPIPE, std::generic_category());
+        p += rc;
+        n -= static_cast<std::size_t>(rc);
+    }
+}
+
+// Returns false on end of file before any data.
+inline bool read_all(int fd, void *buf, std::size_t n)
+{
+    char *p = static_cast<char *>(buf);
+    std::size_t total = 0;
+    while (total < n) {
+        ssize_t rc = ::read(fd, p + total, n - total);
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc < 0)
+            throw std::system_error(errno, std::generic_category());
+        if (rc == 0) {
+            if (total == 0)
+                return false;
+            throw std::system_error(std::make_error_code(std::errc::connection_reset));
+        }
+        total += static_cast<std::size_t>(rc);
+    }
+    return true;
+}
+
+// Read a hyperslab into a new shared memory segment. Returns the segment
+// name, or an empty name if there are no elements.
+template <class T>
+std::string process_read(int ncid, int varid, const index_type& start, const index_type& count,
+                         const stride_type& stride, std::uint64_t& size)
+{
+    static std::uint64_t sequence = 0;
+    size = api::compute_size(count);
+    if (size == 0)
+        return {};
+
+    const std::string name = "/ncpp." + std::to_string(::getpid()) + "." + std::to_string(sequence++);
+    const std::size_t bytes = size * sizeof(T);
+
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category());
+
+    void *addr = MAP_FAILED;
+    int rc = ::ftruncate(fd, static_cast<off_t>(bytes));
+    if (rc == 0)
+        addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int err = errno;
+    ::close(fd);
+    if (rc != 0 || addr == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        throw std::system_error(err, std::generic_category());
+    }
+
+    // Decode directly into the segment.
+    rc = api::impl::detail::get_vars(ncid, varid, start.data(), count.data(), stride.data(), static_cast<T *>(addr));
+    ::munmap(addr, bytes);
+    if (rc != NC_NOERR) {
+        ::shm_unlink(name.c_str());
+        detail::throw_error(rc);
+    }
+    return name;
+}
+
+// Serve requests on a socket until it is closed. Each worker process keeps
+// its own open files.
+[[noreturn]] inline void process_serve(int fd)
+{
+    std::map<std::string, std::unique_ptr<file>> files;
+
+    for (;;) {
+        process_request request;
+        try {
+            if (!read_all(fd, &request, sizeof(request)))
+                break;
+        }
+        catch (...) {
+            break;
+        }
+
+        std::string path(request.path_size, '\0');
+        std::string varname(request.name_size, '\0');
+        index_type start(request.ndims), count(request.ndims);
+        stride_type stride(request.ndims);
+
+        process_reply reply = {};
+        std::string name;
+        try {
+            read_all(fd, &path[0], path.size());
+            read_all(fd, &varname[0], varname.size());
+            read_all(fd, start.data(), start.size() * sizeof(std::size_t));
+            read_all(fd, count.data(), count.size() * sizeof(std::size_t));
+            read_all(fd, stride.data(), stride.size() * sizeof(std::ptrdiff_t));
+
+            auto& f = files[path];
+            if (!f)
+                f = std::make_unique<file>(path);
+
+            int varid;
+            check(nc_inq_varid(f->ncid(), varname.c_str(), &varid));
+
+            const int ncid = f->ncid();
+            switch (request.type) {
+            case 1: name = process_read<char>(ncid, varid, start, count, stride, reply.size); break;
+            case 2: name = process_read<signed char>(ncid, varid, start, count, stride, reply.size); break;
+            case 3: name = process_read<unsigned char>(ncid, varid, start, count, stride, reply.size); break;
+            case 4: name = process_read<short>(ncid, varid, start, count, stride, reply.size); break;
+            case 5: name = process_read<unsigned short>(ncid, varid, start, count, stride, reply.size); break;
+            case 6: name = process_read<int>(ncid, varid, start, count, stride, reply.size); break;
+            case 7: name = process_read<unsigned int>(ncid, varid, start, count, stride, reply.size); break;
+            case 8: name = process_read<long long>(ncid, varid, start, count, stride, reply.size); break;
+            case 9: name = process_read<unsigned long long>(ncid, varid, start, count, stride, reply.size); break;
+            case 10: name = process_read<float>(ncid, varid, start, count, stride, reply.size); break;
+            case 11: name = process_read<double>(ncid, varid, start, count, stride, reply.size); break;
+            default: detail::throw_error(error::invalid_data_type);
+            }
+        }
+        catch (const std::system_error& e) {
+            reply.error = e.code().value();
+            reply.generic = (e.code().category() != error::get_netcdf_category());
+        }
+        catch (...) {
+            reply.error = ENOMEM;
+            reply.generic = 1;
+        }
+
+        reply.name_size = static_cast<std::uint32_t>(name.size());
+        try {
+            write_all(fd, &reply, sizeof(reply));
+            write_all(fd, name.data(), name.size());
+        }
+        catch (...) {
+            if (!name.empty())
+                ::shm_unlink(name.c_str());
+            break;
+        }
+    }
+
+    files.clear();
+    ::_exit(0);
+}
+
+} // namespace detail
+
+/// Pool of forked reader processes. netCDF-C and HDF5 serialize calls
+/// within a process, so reading and decompressing in separate processes
+/// scales across cores. Each worker opens its own files; results are
+/// decoded into POSIX shared memory segments and mapped into the caller
+/// without copying. Create the pool before starting other threads or
+/// opening files, since fork() only duplicates the calling thread.
+class process_pool
+{
+public:
+    explicit process_pool(std::size_t nprocs = std::thread::hardware_concurrency())
+    {
+        nprocs = std::max<std::size_t>(nprocs, 1);
+        for (std::size_t i = 0; i < nprocs; ++i) {
+            int sv[2];
+            if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+                throw std::system_error(errno, std::generic_category());
+
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+            int one = 1;
+            ::setsockopt(sv[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+            pid_t pid = ::fork();
+            if (pid < 0) {
+                const int err = errno;
+                ::close(sv[0]);
+                ::close(sv[1]);
+                shutdown();
+                throw std::system_error(err, std::generic_category());
+            }
+
+            if (pid == 0) {
+                // Worker process: close the parent ends of all sockets.
+                ::close(sv[0]);
+                for (const auto& w : workers_)
+                    ::close(w.fd);
+                detail::process_serve(sv[1]);
+            }
+
+            ::close(sv[1]);
+            workers_.push_back(worker{ sv[0], pid });
+        }
+
+        for (std::size_t i = 0; i < workers_.size(); ++i)
+            threads_.emplace_back([this, i] { run(i); });
+    }
+
+    process_pool(const process_pool&) = delete;
+    process_pool& operator=(const process_pool&) = delete;
+
+    /// Queued requests are completed before the workers exit.
+    ~process_pool() {
+        shutdown();
+    }
+
+    /// Get the number of worker processes.
+    std::size_t size() const noexcept {
+        return workers_.size();
+    }
+
+    /// Read a hyperslab of a variable in a worker process.
+    template <class T>
+    std::future<shared_array<T>> read(const std::filesystem::path& path, const std::string& varname,
+                                      const index_type& start, const index_type& count, const stride_type& stride)
+    {
+        static_assert(detail::process_type<T>() != 0, "unsupported element type");
+
+        if (start.size() != count.size() || start.size() != stride.size())
+            detail::throw_error(error::invalid_argument);
+
+        // Serialize the request.
+        const std::string p = path.string();
+        detail::process_request header = { static_cast<std::uint32_t>(p.size()),
+            static_cast<std::uint32_t>(varname.size()), detail::process_type<T>(),
+            static_cast<std::uint32_t>(start.size()) };
+
+        auto request = std::make_shared<std::string>();
+        request->append(reinterpret_cast<const char *>(&header), sizeof(header));
+        request->append(p);
+        request->append(varname);
+        request->append(reinterpret_cast<const char *>(start.data()), start.size() * sizeof(std::size_t));
+        request->append(reinterpret_cast<const char *>(count.data()), count.size() * sizeof(std::size_t));
+        request->append(reinterpret_cast<const char *>(stride.data()), stride.size() * sizeof(std::ptrdiff_t));
+
+        auto promise = std::make_shared<std::promise<shared_array<T>>>();
+        auto result = promise->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.emplace_back([request, promise](int fd) {
+                try {
+                    promise->set_value(exchange<T>(fd, *request));
+                }
+                catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+        }
+        cv_.notify_one();
+        return result;
+    }
+
+    /// Read a variable selection in a worker process. The variable must be
+    /// from a dataset opened from the same path.
+    template <class T>
+    std::future<shared_array<T>> read(const std::filesystem::path& path, const variable& v) {
+        return read<T>(path, v.name(), v.start(), v.shape(), v.stride());
+    }
+
+private:
+    struct worker
+    {
+        int fd;
+        pid_t pid;
+    };
+
+    template <class T>
+    static shared_array<T> exchange(int fd, const std::string& request)
+    {
+        detail::write_all(fd, request.data(), request.size());
+
+        detail::process_reply reply;
+        if (!detail::read_all(fd, &reply, sizeof(reply)))
+            throw std::system_error(std::make_error_code(std::errc::connection_reset));
+        std::string name(reply.name_size, '\0');
+        detail::read_all(fd, &name[0], name.size());
+
+        if (reply.error != 0) {
+            if (reply.generic)
+                throw std::system_error(reply.error, std::generic_category());
+            detail::throw_error(reply.error);
+        }
+        if (name.empty())
+            return shared_array<T>();
+
+        // Map the segment and remove its name; the mapping keeps it alive.
+        const std::size_t bytes = reply.size * sizeof(T);
+        int sfd = ::shm_open(name.c_str(), O_RDWR, 0600);
+        const int open_err = errno;
+        ::shm_unlink(name.c_str());
+        if (sfd < 0)
+            throw std::system_error(open_err, std::generic_category());
+
+        void *addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, sfd, 0);
+        const int map_err = errno;
+        ::close(sfd);
+        if (addr == MAP_FAILED)
+            throw std::system_error(map_err, std::generic_category());
+
+        return shared_array<T>(addr, static_cast<std::size_t>(reply.size));
+    }
+
+    // Send queued requests to one worker process, one at a time.
+    void run(std::size_t i)
+    {
+        for (;;) {
+            std::function<void(int)> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopped_ || !jobs_.empty(); });
+                if (jobs_.empty())
+                    return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job(workers_[i].fd);
+        }
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_)
+            thread.join();
+        threads_.clear();
+
+        // Workers exit when their socket is shut down. Workers forked by
+        // pools created later inherit a copy of the descriptor, so closing
+        // it alone would not end the connection.
+        for (const auto& w : workers_) {
+            ::shutdown(w.fd, SHUT_RDWR);
+            ::close(w.fd);
+            ::waitpid(w.pid, nullptr, 0);
+        }
+        workers_.clear();
+    }
+
+    std::vector<worker> workers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void(int)>> jobs_;
+    bool stopped_ = false;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace ncpp
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+#endif // NCPP_PROCESS_POOL_HPP
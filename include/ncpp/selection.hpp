@@ -14,7 +14,9 @@
 #include <ncpp/config.hpp>
 
 #include <cstddef>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace ncpp {
@@ -29,6 +31,30 @@ struct selection
     std::ptrdiff_t stride = 1;
 };
 
+/// netCDF coordinate variable nearest value selection type. Each value
+/// selects the nearest coordinate, within the tolerance if specified. The
+/// tolerance has the type of the difference of two values.
+template <class T>
+struct nearest_selection
+{
+    std::string coordinate;
+    std::vector<T> values;
+    std::optional<decltype(std::declval<T>() - std::declval<T>())> tolerance;
+};
+
+/// Latitude and longitude box selection on two-dimensional auxiliary
+/// coordinate variables, in degrees. The longitude range wraps if
+/// min_lon > max_lon.
+struct bbox_selection
+{
+    std::string latitude;
+    std::string longitude;
+    double min_lat;
+    double max_lat;
+    double min_lon;
+    double max_lon;
+};
+
 } // namespace ncpp
 
 #endif // NCPP_SELECTION_HPP
\ No newline at end of file
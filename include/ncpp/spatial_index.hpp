@@ -0,0 +1,244 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_SPATIAL_INDEX_HPP
+#define NCPP_SPATIAL_INDEX_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/check.hpp>
+#include <ncpp/error.hpp>
+#include <ncpp/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace ncpp {
+
+/// Static k-d tree over the points of a curvilinear grid, from latitude and
+/// longitude in degrees. Points are stored as unit vectors, so distances do
+/// not depend on the longitude convention and are correct near the poles
+/// and the antimeridian. Points with invalid coordinates are skipped.
+class spatial_index
+{
+public:
+    /// Build the index from row-major latitude and longitude values.
+    spatial_index(const std::vector<double>& lat, const std::vector<double>& lon, const index_type& shape)
+        : shape_(shape)
+    {
+        if (lat.size() != lon.size())
+            detail::throw_error(error::invalid_dimension_size);
+
+        points_.reserve(lat.size());
+        for (std::size_t n = 0; n < lat.size(); ++n) {
+            if (!std::isfinite(lat[n]) || !std::isfinite(lon[n]) || std::abs(lat[n]) > 90.0 || std::abs(lon[n]) > 720.0)
+                continue;
+            point p;
+            p.xyz = to_unit_vector(lat[n], lon[n]);
+            p.lat = lat[n];
+            p.lon = lon[n];
+            p.offset = n;
+            points_.push_back(p);
+        }
+
+        build(0, points_.size(), 0);
+    }
+
+    /// Get the shape of the grid.
+    const index_type& shape() const noexcept {
+        return shape_;
+    }
+
+    /// Get the number of indexed points.
+    std::size_t size() const noexcept {
+        return points_.size();
+    }
+
+    /// Get the linear offset of the grid point nearest to a location.
+    std::size_t nearest(double lat, double lon) const
+    {
+        if (points_.empty() || !std::isfinite(lat) || !std::isfinite(lon))
+            detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+
+        const auto q = to_unit_vector(lat, lon);
+        std::size_t best = 0;
+        double best_dist = std::numeric_limits<double>::infinity();
+        nearest(q, 0, points_.size(), 0, best, best_dist);
+        return points_[best].offset;
+    }
+
+    /// Get the sorted linear offsets of the grid points within a latitude and
+    /// longitude box. The longitude range wraps if min_lon > max_lon.
+    std::vector<std::size_t> within(double min_lat, double max_lat, double min_lon, double max_lon) const
+    {
+        if (min_lat > max_lat)
+            std::swap(min_lat, max_lat);
+
+        double width = max_lon - min_lon;
+        if (width < 0.0)
+            width += 360.0;
+
+        // Bounding box of the spherical rectangle in three dimensions.
+        const auto box = bounds(min_lat, max_lat, min_lon, width);
+
+        std::vector<std::size_t> result;
+        within(box, 0, points_.size(), 0, [&](const point& p) {
+            if (p.lat >= min_lat && p.lat <= max_lat && (width >= 360.0 ||
+                std::fmod(std::fmod(p.lon - min_lon, 360.0) + 360.0, 360.0) <= width))
+                result.push_back(p.offset);
+        });
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    using vector3 = std::array<double, 3>;
+
+    struct point
+    {
+        vector3 xyz;
+        double lat;
+        double lon;
+        std::size_t offset;
+    };
+
+    static vector3 to_unit_vector(double lat, double lon)
+    {
+        constexpr double deg = 3.14159265358979323846 / 180.0;
+        const double c = std::cos(lat * deg);
+        return vector3{ c * std::cos(lon * deg), c * std::sin(lon * deg), std::sin(lat * deg) };
+    }
+
+    static double distance2(const vector3& a, const vector3& b)
+    {
+        const double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // Get the range of cos(x) and sin(x) for x in [lon, lon + width] degrees.
+    static std::array<double, 4> trig_range(double lon, double width)
+    {
+        constexpr double deg = 3.14159265358979323846 / 180.0;
+        if (width >= 360.0)
+            return { -1.0, 1.0, -1.0, 1.0 };
+
+        double cmin = std::min(std::cos(lon * deg), std::cos((lon + width) * deg));
+        double cmax = std::max(std::cos(lon * deg), std::cos((lon + width) * deg));
+        double smin = std::min(std::sin(lon * deg), std::sin((lon + width) * deg));
+        double smax = std::max(std::sin(lon * deg), std::sin((lon + width) * deg));
+
+        // Include the extrema at multiples of 90 degrees within the range.
+        for (double k = std::ceil(lon / 90.0) * 90.0; k <= lon + width; k += 90.0) {
+            switch (static_cast<int>(std::fmod(std::fmod(k, 360.0) + 360.0, 360.0) / 90.0 + 0.5) % 4) {
+                case 0: cmax = 1.0; break;
+                case 1: smax = 1.0; break;
+                case 2: cmin = -1.0; break;
+                case 3: smin = -1.0; break;
+            }
+        }
+        return { cmin, cmax, smin, smax };
+    }
+
+    // Get the lower and upper bounds of a latitude and longitude box.
+    static std::array<vector3, 2> bounds(double min_lat, double max_lat, double min_lon, double width)
+    {
+        constexpr double deg = 3.14159265358979323846 / 180.0;
+        constexpr double eps = 1e-9;
+
+        // Range of cos(lat), which is nonnegative.
+        const double rmin = std::min(std::cos(min_lat * deg), std::cos(max_lat * deg));
+        const double rmax = (min_lat <= 0.0 && max_lat >= 0.0) ? 1.0
+            : std::max(std::cos(min_lat * deg), std::cos(max_lat * deg));
+
+        const auto t = trig_range(min_lon, width);
+        auto scale = [&](double lo, double hi) {
+            return std::array<double, 2>{ lo >= 0.0 ? rmin * lo : rmax * lo, hi >= 0.0 ? rmax * hi : rmin * hi };
+        };
+        const auto x = scale(t[0], t[1]);
+        const auto y = scale(t[2], t[3]);
+
+        return { vector3{ x[0] - eps, y[0] - eps, std::sin(min_lat * deg) - eps },
+                 vector3{ x[1] + eps, y[1] + eps, std::sin(max_lat * deg) + eps } };
+    }
+
+    // Arrange the points so the median of each range splits the next axis.
+    void build(std::size_t lo, std::size_t hi, std::size_t axis)
+    {
+        if (hi - lo < 2)
+            return;
+        const std::size_t mid = lo + (hi - lo) / 2;
+        std::nth_element(points_.begin() + lo, points_.begin() + mid, points_.begin() + hi,
+            [axis](const point& a, const point& b) { return a.xyz[axis] < b.xyz[axis]; });
+        build(lo, mid, (axis + 1) % 3);
+        build(mid + 1, hi, (axis + 1) % 3);
+    }
+
+    void nearest(const vector3& q, std::size_t lo, std::size_t hi, std::size_t axis,
+                 std::size_t& best, double& best_dist) const
+    {
+        if (lo >= hi)
+            return;
+        const std::size_t mid = lo + (hi - lo) / 2;
+        const point& p = points_[mid];
+
+        const double d = distance2(q, p.xyz);
+        if (d < best_dist || (d == best_dist && p.offset < points_[best].offset)) {
+            best = mid;
+            best_dist = d;
+        }
+
+        // Search the near side first, and the far side only if the splitting
+        // plane is closer than the best point.
+        const double delta = q[axis] - p.xyz[axis];
+        const std::size_t next = (axis + 1) % 3;
+        if (delta < 0.0) {
+            nearest(q, lo, mid, next, best, best_dist);
+            if (delta * delta <= best_dist)
+                nearest(q, mid + 1, hi, next, best, best_dist);
+        }
+        else {
+            nearest(q, mid + 1, hi, next, best, best_dist);
+            if (delta * delta <= best_dist)
+                nearest(q, lo, mid, next, best, best_dist);
+        }
+    }
+
+    template <class F>
+    void within(const std::array<vector3, 2>& box, std::size_t lo, std::size_t hi, std::size_t axis, F&& f) const
+    {
+        if (lo >= hi)
+            return;
+        const std::size_t mid = lo + (hi - lo) / 2;
+        const point& p = points_[mid];
+
+        if (p.xyz[0] >= box[0][0] && p.xyz[0] <= box[1][0] &&
+            p.xyz[1] >= box[0][1] && p.xyz[1] <= box[1][1] &&
+            p.xyz[2] >= box[0][2] && p.xyz[2] <= box[1][2])
+            f(p);
+
+        const std::size_t next = (axis + 1) % 3;
+        if (box[0][axis] <= p.xyz[axis])
+            within(box, lo, mid, next, f);
+        if (box[1][axis] >= p.xyz[axis])
+            within(box, mid + 1, hi, next, f);
+    }
+
+    index_type shape_;
+    std::vector<point> points_;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_SPATIAL_INDEX_HPP
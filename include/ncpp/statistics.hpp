@@ -0,0 +1,74 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_STATISTICS_HPP
+#define NCPP_STATISTICS_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <ncpp/detail/kernels.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace ncpp {
+
+/// Summary statistics for a set of values.
+struct statistics
+{
+    /// Number of valid values.
+    std::size_t count = 0;
+
+    /// Sum of valid values.
+    double sum = 0.0;
+
+    /// Minimum valid value, or +infinity if there are no values.
+    double min = std::numeric_limits<double>::infinity();
+
+    /// Maximum valid value, or -infinity if there are no values.
+    double max = -std::numeric_limits<double>::infinity();
+
+    /// Get the mean, or NaN if there are no values.
+    double mean() const noexcept {
+        return count ? sum / static_cast<double>(count) : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /// Add the values where valid is nonzero.
+    template <class T>
+    void accumulate(const T *in, const unsigned char *valid, std::size_t n) noexcept {
+        detail::accumulate(in, valid, n, count, sum, min, max);
+    }
+
+    /// Combine with the statistics for another set of values.
+    void merge(const statistics& rhs) noexcept
+    {
+        count += rhs.count;
+        sum += rhs.sum;
+        min = std::min(min, rhs.min);
+        max = std::max(max, rhs.max);
+    }
+
+    /// Apply a linear transform x * scale + offset to the values.
+    void transform(double scale, double offset) noexcept
+    {
+        if (count == 0)
+            return;
+        sum = sum * scale + offset * static_cast<double>(count);
+        double lo = min * scale + offset;
+        double hi = max * scale + offset;
+        min = std::min(lo, hi);
+        max = std::max(lo, hi);
+    }
+};
+
+} // namespace ncpp
+
+#endif // NCPP_STATISTICS_HPP
@@ -0,0 +1,149 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef NCPP_THREAD_POOL_HPP
+#define NCPP_THREAD_POOL_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ncpp/config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ncpp {
+
+/// Work-stealing thread pool for compute tasks. Each worker has its own
+/// task queue; idle workers steal from the other queues. Tasks that call
+/// netCDF-C must hold a detail::netcdf_lock, as must any other thread that
+/// calls netCDF-C while tasks are running. The parallel reads of variable
+/// (for_each_block, transform, reduce) and block_reader take the lock.
+class thread_pool
+{
+public:
+    explicit thread_pool(std::size_t nthreads = std::thread::hardware_concurrency())
+    {
+        nthreads = std::max<std::size_t>(nthreads, 1);
+        for (std::size_t i = 0; i < nthreads; ++i)
+            queues_.emplace_back(std::make_unique<queue>());
+        for (std::size_t i = 0; i < nthreads; ++i)
+            threads_.emplace_back([this, i] { run(i); });
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /// Queued tasks are completed before the workers are joined.
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_)
+            thread.join();
+    }
+
+    /// Get the number of worker threads.
+    std::size_t size() const noexcept {
+        return threads_.size();
+    }
+
+    /// Queue a task. Returns a future for the result.
+    template <class F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& f)
+    {
+        using result_type = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(f));
+        auto result = task->get_future();
+
+        auto& q = *queues_[next_++ % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.tasks.emplace_back([task] { (*task)(); });
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++pending_;
+        }
+        cv_.notify_one();
+        return result;
+    }
+
+private:
+    struct queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Take a task from the back of the worker queue, or steal one from the
+    // front of another queue.
+    bool pop(std::size_t i, std::function<void()>& task)
+    {
+        for (std::size_t k = 0; k < queues_.size(); ++k) {
+            auto& q = *queues_[(i + k) % queues_.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty())
+                continue;
+            if (k == 0) {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            }
+            else {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void run(std::size_t i)
+    {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopped_ || pending_ > 0; });
+                if (pending_ == 0)
+                    return;
+                --pending_;
+            }
+
+            // Each pending count corresponds to a queued task.
+            std::function<void()> task;
+            while (!pop(i, task))
+                std::this_thread::yield();
+            task();
+        }
+    }
+
+    std::vector<std::unique_ptr<queue>> queues_;
+    std::atomic<std::size_t> next_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::size_t pending_ = 0;
+    bool stopped_ = false;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace ncpp
+
+#endif // NCPP_THREAD_POOL_HPP
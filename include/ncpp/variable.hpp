@@ -21,20 +21,34 @@
 
 #include <ncpp/config.hpp>
 
+#include <ncpp/detail/kernels.hpp>
+#include <ncpp/detail/netcdf_lock.hpp>
 #include <ncpp/detail/utilities.hpp>
 #include <ncpp/functions/variable.hpp>
 #include <ncpp/functions/ndarray.hpp>
 #include <ncpp/attributes.hpp>
+#include <ncpp/block_reader.hpp>
+#include <ncpp/cancellation.hpp>
+#include <ncpp/coordinate_view.hpp>
 #include <ncpp/dimensions.hpp>
+#include <ncpp/iterator.hpp>
+#include <ncpp/mask.hpp>
+#include <ncpp/metadata.hpp>
 #include <ncpp/selection.hpp>
+#include <ncpp/statistics.hpp>
+#include <ncpp/thread_pool.hpp>
 #include <ncpp/check.hpp>
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <future>
 #include <iterator>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -52,31 +66,36 @@
 #endif // NCPP_USE_BOOST
 
 // TODO:
-// - Account for scale_factor, add_offset
-// - Use optional for _FillValue, missing_value, valid_min, valid_max, valid_range
 // - Chained coordinates lookup for other variables indexed on the coordinate dimension
 //   with an instance_dimension attribute
 
 namespace ncpp {
 
 class variables_type;
+class indexed_variable;
 
-/// netCDF variable type.
+/// netCDF variable type. Lightweight view on the dataset metadata with
+/// an optional hyperslab selection.
 class variable
 {
     friend class variables_type;
 
 public:
-    variable(int ncid, int varid) :
-        dims(ncid, varid), atts(ncid, varid), ncid_(ncid), varid_(varid)
+    variable(std::shared_ptr<const metadata> meta, int varid) :
+        dims(meta, varid), atts(meta, varid), meta_(std::move(meta)), varid_(varid)
     {
-        start_.resize(dims.size(), 0);
-        shape_.resize(dims.size(), 0);
-        stride_.resize(dims.size(), 1);
-        std::transform(dims.begin(), dims.end(), shape_.begin(),
-            [](const auto& dim) { return dim.length(); });
+        shape_ = meta_->var(varid).shape;
+        start_.resize(shape_.size(), 0);
+        stride_.resize(shape_.size(), 1);
     }
 
+    /// Construct a view on a new metadata snapshot of the dataset. Only the
+    /// dimensions and variable IDs are read up front; use the constructor
+    /// taking a shared snapshot for several views of one dataset.
+    variable(int ncid, int varid) :
+        variable(std::make_shared<const metadata>(ncid), varid)
+    {}
+
     /// Dimensions associated with the variable.
     dimensions_type dims;
 
@@ -93,7 +112,7 @@ public:
     }
 
     bool operator==(const variable& rhs) const {
-        return (ncid_ == rhs.ncid_ && varid_ == rhs.varid_);
+        return (ncid() == rhs.ncid() && varid_ == rhs.varid_);
     }
 
     bool operator!=(const variable& rhs) const {
@@ -101,13 +120,13 @@ public:
     }
 
     /// Get the variable name.
-    std::string name() const {
-        return api::inq_varname(ncid_, varid_);
+    const std::string& name() const {
+        return meta_->var(varid_).name;
     }
 
     /// Get the netCDF ID.
     int ncid() const {
-        return ncid_;
+        return meta_->ncid();
     }
 
     /// Get the variable ID.
@@ -117,7 +136,7 @@ public:
 
     /// Get the netCDF data type ID for the variable.
     int netcdf_type() const {
-        return api::inq_vartype(ncid_, varid_);
+        return meta_->var(varid_).type;
     }
 
     /// Get the start indexes of the data array.
@@ -142,17 +161,71 @@ public:
 
     template <class T>
     std::optional<T> fill_value() const {
-        return api::inq_var_fill<T>(ncid_, varid_);
+        return api::inq_var_fill<T>(ncid(), varid_);
+    }
+
+    /// Get the valid data test from the _FillValue, missing_value,
+    /// valid_min, valid_max and valid_range attributes. The default fill
+    /// value is used if _FillValue is not set, except for byte types.
+    template <class T>
+    value_mask<T> mask() const {
+        return load_mask<T, T>();
     }
 
     /// Returns the variable storage type.
     var_storage_type storage_type() const {
-        return api::inq_var_storage(ncid_, varid_).value();
+        return api::inq_var_storage(ncid(), varid_).value();
     }
 
     /// Returns the chunk size for each dimension.
     std::vector<std::size_t> chunk_sizes() const {
-        return api::inq_var_chunksizes(ncid_, varid_);
+        return api::inq_var_chunksizes(ncid(), varid_);
+    }
+
+    /// Get the chunk cache settings for the variable.
+    chunk_cache get_chunk_cache() const {
+        return api::get_var_chunk_cache(ncid(), varid_);
+    }
+
+    /// Set the chunk cache settings for the variable.
+    void set_chunk_cache(const chunk_cache& cache) const {
+        api::set_var_chunk_cache(ncid(), varid_, cache);
+    }
+
+    /// Size the chunk cache so that every chunk touched by one slice of the
+    /// selection along the first dimension stays resident while the slices
+    /// are read in turn. The cache is never made smaller, and is limited to
+    /// NCPP_MAX_CHUNK_CACHE_SIZE bytes. Returns the settings, or zero if the
+    /// variable is not chunked. Throws if a stride is not positive.
+    chunk_cache tune_chunk_cache() const
+    {
+        if (std::any_of(stride_.begin(), stride_.end(), [](std::ptrdiff_t s) { return s < 1; }))
+            detail::throw_error(error::illegal_stride);
+
+        auto storage = api::inq_var_storage(ncid(), varid_);
+        if (!storage.has_value() || storage.value() != var_storage_type::chunked)
+            return chunk_cache{ 0, 0, 0.0f };
+
+        // Number of chunks intersecting one slice.
+        const index_type chunkshape = chunk_sizes();
+        std::size_t nchunks = 1;
+        for (std::size_t d = 1; d < shape_.size(); ++d)
+            nchunks *= api::compute_chunk_segments(start_[d], shape_[d], stride_[d],
+                std::max<std::size_t>(chunkshape[d], 1)).size();
+
+        const std::size_t chunkbytes = api::inq_type_size(ncid(), netcdf_type()) * api::compute_size(chunkshape);
+        const std::size_t limit = NCPP_MAX_CHUNK_CACHE_SIZE;
+        const std::size_t needed = (chunkbytes > 0 && nchunks > limit / chunkbytes) ? limit
+            : std::min(nchunks * chunkbytes, limit);
+
+        chunk_cache cache = get_chunk_cache();
+        if (needed > cache.size && chunkbytes > 0) {
+            // HDF5 recommends about 100 hash slots per chunk in the cache.
+            cache.size = needed;
+            cache.nelems = std::max(cache.nelems, detail::next_prime(100 * (needed / chunkbytes)));
+            set_chunk_cache(cache);
+        }
+        return cache;
     }
 
 #ifdef NC_HAS_HDF5
@@ -160,13 +233,13 @@ public:
     /// Returns the HDF5 filter ID for the variable.
     /// See also: https://portal.hdfgroup.org/display/support/Filters
     unsigned int filter_type() const {
-        return api::inq_var_filter_id(ncid_, varid_).value();
+        return api::inq_var_filter_id(ncid(), varid_).value();
     }
 
     /// Returns the HDF5 filter name for the variable.
     /// See also: https://portal.hdfgroup.org/display/support/Filters
     std::string filter_name() const {
-        return api::inq_var_filter_name(ncid_, varid_);
+        return api::inq_var_filter_name(ncid(), varid_);
     }
 
 #endif // NC_HAS_HDF5
@@ -191,18 +264,10 @@ public:
     template <class T>
     variable select(selection<T>& s) const
     {
-        // Read the coordinate variable.
+        // Get the cached coordinate index, in ascending order.
         std::size_t idx = coordinate_position(s.coordinate);
-        int cvarid = dims.at(idx).cvarid_;
-        variable cv(ncid_, cvarid);
-        auto coords = cv.values<T>();
-        
-        // Handle decreasing values.
-        bool reversed = false;
-        if (!std::is_sorted(coords.begin(), coords.end())) {
-            std::reverse(coords.begin(), coords.end());
-            reversed = true;
-        }
+        const auto& index = meta_->coordinates<T>(dims.at(idx).cvarid_);
+        const auto& coords = index.values;
         
         if (s.min_value > s.max_value)
             std::swap(s.min_value, s.max_value);
@@ -212,7 +277,7 @@ public:
         auto upper = std::upper_bound(coords.begin(), coords.end(), s.max_value);
         
         variable v(*this);
-        v.start_.at(idx) = reversed ? static_cast<std::size_t>(std::distance(upper, coords.end()))
+        v.start_.at(idx) = index.descending ? static_cast<std::size_t>(std::distance(upper, coords.end()))
                                     : static_cast<std::size_t>(std::distance(coords.begin(), lower));
         
         v.shape_.at(idx) = static_cast<std::size_t>(std::distance(lower, upper)) / std::abs(s.stride);
@@ -220,6 +285,133 @@ public:
         return v;
     }
 
+    /// \group isel
+    /// Select elements along a dimension by a list of indexes within the
+    /// current selection. Indexes may be in any order or repeated.
+    indexed_variable isel(const std::string& dimname, const index_type& indexes) const;
+
+    /// \group isel
+    /// Select elements along a dimension where a mask is true.
+    indexed_variable where(const std::string& dimname, const std::vector<bool>& mask) const;
+
+    /// \group select
+    /// Select the nearest coordinate values for one or more dimensions.
+    template <class... Ts>
+    indexed_variable select(nearest_selection<Ts>&&... selections) const;
+
+    /// Get the positions within the selection of the coordinate values
+    /// nearest to each target. Targets are sorted and matched in a single
+    /// pass over the cached coordinate index. Ties resolve to the lower
+    /// value. Throws if a target is further than the tolerance from every
+    /// coordinate value. The tolerance has the type of the difference of two
+    /// values, e.g. a duration for time_point coordinates.
+    template <class T>
+    index_type nearest(const std::string& coordvarname, const std::vector<T>& targets,
+                       std::optional<decltype(std::declval<T>() - std::declval<T>())> tolerance = std::nullopt) const
+    {
+        std::size_t idx = coordinate_position(coordvarname);
+        const auto& index = meta_->coordinates<T>(dims.at(idx).cvarid_);
+        const std::size_t n = shape_.at(idx);
+        const std::size_t start = start_.at(idx);
+        const std::size_t stride = static_cast<std::size_t>(stride_.at(idx));
+
+        // Get the selected coordinate value by rank, in ascending order.
+        auto position = [&](std::size_t r) { return index.descending ? n - 1 - r : r; };
+        auto value = [&](std::size_t r) -> const T& { return index.at(start + position(r) * stride); };
+
+        std::vector<std::size_t> order(targets.size());
+        std::iota(order.begin(), order.end(), std::size_t(0));
+        for (const auto& x : targets) {
+            if (n == 0 || x != x) // NaN
+                detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+        }
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+            { return targets[a] < targets[b]; });
+
+        index_type result(targets.size());
+        std::size_t r = 0;
+        for (const auto& i : order) {
+            const T& x = targets[i];
+
+            // Find the first value not less than the target. Targets are
+            // sorted, so the search starts from the previous result.
+            for (std::size_t count = n - r; count > 0; /**/) {
+                std::size_t step = count / 2;
+                if (value(r + step) < x) {
+                    r += step + 1;
+                    count -= step + 1;
+                }
+                else {
+                    count = step;
+                }
+            }
+
+            const bool below = (r == n) || (r > 0 && x - value(r - 1) <= value(r) - x);
+            const std::size_t best = below ? r - 1 : r;
+            if (tolerance.has_value() && (below ? x - value(best) : value(best) - x) > tolerance.value())
+                detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+            result[i] = position(best);
+        }
+        return result;
+    }
+
+    /// Get the position within the selection of the coordinate value
+    /// nearest to a target.
+    template <class T>
+    std::size_t nearest(const std::string& coordvarname, const T& target,
+                        std::optional<decltype(std::declval<T>() - std::declval<T>())> tolerance = std::nullopt) const
+    {
+        return nearest(coordvarname, std::vector<T>{ target }, tolerance).front();
+    }
+
+    /// Select the grid point nearest to a location, using two-dimensional
+    /// latitude and longitude variables in degrees. The selection is reset
+    /// for the two grid dimensions.
+    variable nearest_point(const std::string& latname, const std::string& lonname, double lat, double lon) const
+    {
+        const auto grid = grid_positions(latname, lonname);
+        const auto& index = meta_->spatial(grid.latid, grid.lonid);
+        const std::size_t offset = index.nearest(lat, lon);
+
+        variable v(*this);
+        const std::size_t pos[2] = { offset / index.shape()[1], offset % index.shape()[1] };
+        for (std::size_t i = 0; i < 2; ++i) {
+            v.start_.at(grid.dims[i]) = pos[i];
+            v.shape_.at(grid.dims[i]) = 1;
+            v.stride_.at(grid.dims[i]) = 1;
+        }
+        return v;
+    }
+
+    /// \group select
+    /// Select the smallest hyperslab containing the grid points within a
+    /// latitude and longitude box. The selection is reset for the two grid
+    /// dimensions.
+    variable select(const bbox_selection& s) const
+    {
+        const auto grid = grid_positions(s.latitude, s.longitude);
+        const auto& index = meta_->spatial(grid.latid, grid.lonid);
+        const auto offsets = index.within(s.min_lat, s.max_lat, s.min_lon, s.max_lon);
+
+        std::size_t lower[2] = { index.shape()[0], index.shape()[1] };
+        std::size_t upper[2] = { 0, 0 };
+        for (const auto& offset : offsets) {
+            const std::size_t pos[2] = { offset / index.shape()[1], offset % index.shape()[1] };
+            for (std::size_t i = 0; i < 2; ++i) {
+                lower[i] = std::min(lower[i], pos[i]);
+                upper[i] = std::max(upper[i], pos[i] + 1);
+            }
+        }
+
+        variable v(*this);
+        for (std::size_t i = 0; i < 2; ++i) {
+            v.start_.at(grid.dims[i]) = offsets.empty() ? 0 : lower[i];
+            v.shape_.at(grid.dims[i]) = offsets.empty() ? 0 : upper[i] - lower[i];
+            v.stride_.at(grid.dims[i]) = 1;
+        }
+        return v;
+    }
+
     /// Returns a vector with one variable for each consecutive equal value
     /// range in the coordinate variable. Stride will be reset to 1 in the
     /// coordinate variable dimension.
@@ -255,30 +447,33 @@ public:
     void set_coordinate(const std::string& dimname, const std::string& coordvarname)
     {
         // Get the associated dimension.
-        auto it = std::find(dims.begin(), dims.end(), dims[dimname]);
-        if (it == dims.end())
+        auto n = dims.position(dimname);
+        if (!n.has_value())
             detail::throw_error(error::invalid_dimension);
 
-        dimension& dim = *it;
-
-        int cvarid = api::inq_varid(ncid_, coordvarname).value_or(-1);
-        if (cvarid == -1)
+        auto cvarid = meta_->find_var(coordvarname);
+        if (!cvarid.has_value())
             detail::throw_error(error::variable_not_found);
         
-        int cvartype = api::inq_vartype(ncid_, cvarid);
-        auto cvardimids = api::inq_vardimid(ncid_, cvarid);
+        const auto& cvar = meta_->var(cvarid.value());
 
         // Ensure the variable is one-dimensional; allow two dimensions for classic strings.
-        if ((cvartype != NC_CHAR && cvardimids.size() != 1) ||
-            (cvartype == NC_CHAR && cvardimids.size() > 2))
+        if ((cvar.type != NC_CHAR && cvar.dimids.size() != 1) ||
+            (cvar.type == NC_CHAR && cvar.dimids.size() > 2))
             detail::throw_error(error::invalid_dimension_size);
 
         // Ensure the variable is indexed by this dimension.
-        if (cvardimids.at(0) != dim.dimid())
+        if (!metadata::is_coordinate(cvar, dims.dimid(n.value())))
             detail::throw_error(error::invalid_dimension);
         
-        // Update the coordinate variable ID for the dimension.
-        dim.cvarid_ = cvarid;
+        // Update the coordinate variable ID for the dimension. Overrides are
+        // local to this variable and its copies.
+        if (dims.cvarids_.empty()) {
+            dims.cvarids_.reserve(dims.size());
+            for (const auto& dim : dims)
+                dims.cvarids_.push_back(dim.cvarid_);
+        }
+        dims.cvarids_[n.value()] = cvarid.value();
     }
 
     /// Get the coordinates for all dimensions as a vector of tuples.
@@ -301,6 +496,25 @@ public:
         return detail::tuple_cartesian_product(columns);
     }
     
+    /// Get a lazy view of the coordinates for all dimensions, in the same
+    /// order as the values. Only the coordinates for each dimension are
+    /// stored; tuples are computed on access.
+    template <class... Ts>
+    coordinate_view<Ts...> coordinates_view() const
+    {
+        // Make sure we have the correct number of columns.
+        if (sizeof...(Ts) != dims.size())
+            detail::throw_error(error::invalid_dimension_size);
+        
+        std::tuple<std::vector<Ts>...> columns;
+        detail::apply_index([&] (auto i, auto&& column) {
+            using value_type = typename std::decay_t<decltype(column)>::value_type;
+            column = coordinates<value_type>(i);
+        }, columns);
+        
+        return coordinate_view<Ts...>(std::move(columns));
+    }
+
     /// Get the coordinates for one dimension by position as a vector.
     template <class T>
     std::vector<T> coordinates(std::size_t pos) const
@@ -308,9 +522,20 @@ public:
         if (pos >= dims.size())
             detail::throw_error(error::invalid_dimension);
         
-        // Get the coordinate values.
+        // Get the coordinate values from the cached index if possible.
         int cvarid = dims.at(pos).cvarid_;
-        variable cv(ncid_, cvarid);
+        if (meta_->var(cvarid).dimids.size() == 1) {
+            const auto& index = meta_->coordinates<T>(cvarid);
+            std::vector<T> coords;
+            coords.reserve(shape_.at(pos));
+            for (std::size_t i = 0; i < shape_.at(pos); ++i) {
+                auto p = static_cast<std::ptrdiff_t>(start_.at(pos)) + static_cast<std::ptrdiff_t>(i) * stride_.at(pos);
+                coords.push_back(index.at(static_cast<std::size_t>(p)));
+            }
+            return coords;
+        }
+
+        variable cv(meta_, cvarid);
         cv.start_.at(0) = start_.at(pos);
         cv.shape_.at(0) = shape_.at(pos);
         cv.stride_.at(0) = stride_.at(pos);
@@ -326,16 +551,48 @@ public:
         return coordinates<T>(idx);
     }
 
+    // Two-dimensional latitude and longitude variables, and the positions
+    // of their dimensions in this variable.
+    struct grid_info
+    {
+        int latid;
+        int lonid;
+        std::size_t dims[2];
+    };
+
+    grid_info grid_positions(const std::string& latname, const std::string& lonname) const
+    {
+        auto latid = meta_->find_var(latname);
+        auto lonid = meta_->find_var(lonname);
+        if (!latid.has_value() || !lonid.has_value())
+            detail::throw_error(error::variable_not_found);
+
+        const auto& dimids = meta_->var(latid.value()).dimids;
+        if (dimids.size() != 2)
+            detail::throw_error(error::invalid_dimension_size);
+
+        grid_info result = { latid.value(), lonid.value(), { 0, 0 } };
+        for (std::size_t i = 0; i < 2; ++i) {
+            std::size_t n = 0;
+            while (n < dims.size() && dims.dimid(n) != dimids[i])
+                ++n;
+            if (n == dims.size())
+                detail::throw_error(error::invalid_dimension);
+            result.dims[i] = n;
+        }
+        return result;
+    }
+
     // Get the dimension position for a coordinate variable.
     std::size_t coordinate_position(const std::string& coordvarname) const
     {
-        int cvarid = api::inq_varid(ncid_, coordvarname).value_or(-1);
-        if (cvarid == -1)
+        auto cvarid = meta_->find_var(coordvarname);
+        if (!cvarid.has_value())
             detail::throw_error(error::variable_not_found);
 
         // Find the dimension associated with this coordinate variable.
         const auto it = std::find_if(dims.begin(), dims.end(), [&](const auto& dim)
-            { return dim.cvarid_ == cvarid; });
+            { return dim.cvarid_ == cvarid.value(); });
 
         if (it == dims.end())
             detail::throw_error(error::variable_not_found);
@@ -343,18 +600,320 @@ public:
         return static_cast<std::size_t>(std::distance(dims.begin(), it));
     }
 
+    /// Get an iterator over the intersections of the selection with the
+    /// chunk grid. Call next() to move to the first block.
+    chunk_iterator chunks() const {
+        return chunk_iterator(ncid(), varid_, start_, shape_, stride_);
+    }
+
     /// Copy values to allocated memory.
     template <class T>
     void read(T *out) const
     {
-        check(api::impl::detail::get_vars(ncid_, varid_, start_.data(), shape_.data(), stride_.data(), out));
+        check(api::impl::detail::get_vars(ncid(), varid_, start_.data(), shape_.data(), stride_.data(), out));
+    }
+
+    /// Copy values to allocated memory with capacity for n elements.
+    template <class T>
+    void read(T *out, std::size_t n) const
+    {
+        if (n < size())
+            detail::throw_error(error::invalid_argument);
+        read(out);
+    }
+
+    /// Copy values to a contiguous container such as std::vector or
+    /// std::array. The container is not resized; its size must be at least
+    /// size().
+    template <class Container, class = decltype(std::declval<Container&>().data())>
+    void read(Container& out) const
+    {
+        read(out.data(), out.size());
+    }
+
+    /// Copy values at a list of indexes within the selection to allocated
+    /// memory, in request order. Indexes are grouped by chunk, and each chunk
+    /// is read once using the smallest hyperslab covering its indexes.
+    template <class T>
+    void gather(const std::vector<index_type>& indexes, T *out) const
+    {
+        const std::size_t ndims = shape_.size();
+        index_type chunkshape = chunk_iterator::default_chunkshape(ncid(), varid_);
+        const auto& varshape = meta_->var(varid_).shape;
+        index_type nchunks(ndims);
+        for (std::size_t d = 0; d < ndims; ++d) {
+            chunkshape[d] = std::max<std::size_t>(chunkshape[d], 1);
+            nchunks[d] = (varshape[d] + chunkshape[d] - 1) / chunkshape[d];
+        }
+
+        // Convert to file indexes and sort requests by chunk.
+        std::vector<std::size_t> points(indexes.size() * ndims);
+        std::vector<std::pair<std::size_t, std::size_t>> order(indexes.size());
+        for (std::size_t i = 0; i < indexes.size(); ++i) {
+            const auto& index = indexes[i];
+            if (index.size() != ndims)
+                detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+
+            std::size_t chunk = 0;
+            for (std::size_t d = 0; d < ndims; ++d) {
+                if (index[d] >= shape_[d])
+                    detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
+                std::size_t p = start_[d] + index[d] * static_cast<std::size_t>(stride_[d]);
+                points[i * ndims + d] = p;
+                chunk = chunk * nchunks[d] + p / chunkshape[d];
+            }
+            order[i] = std::make_pair(chunk, i);
+        }
+        std::sort(order.begin(), order.end());
+
+        std::vector<T> buffer;
+        index_type lower(ndims), upper(ndims), count(ndims);
+        const stride_type unit(ndims, 1);
+        for (auto first = order.begin(); first != order.end(); /**/) {
+            auto last = std::find_if(first, order.end(),
+                [&](const auto& o) { return o.first != first->first; });
+
+            // Find the hyperslab covering the indexes in this chunk.
+            const std::size_t *p = &points[first->second * ndims];
+            std::copy_n(p, ndims, lower.begin());
+            std::copy_n(p, ndims, upper.begin());
+            for (auto it = first; it != last; ++it) {
+                p = &points[it->second * ndims];
+                for (std::size_t d = 0; d < ndims; ++d) {
+                    lower[d] = std::min(lower[d], p[d]);
+                    upper[d] = std::max(upper[d], p[d]);
+                }
+            }
+            for (std::size_t d = 0; d < ndims; ++d)
+                count[d] = upper[d] - lower[d] + 1;
+
+            buffer.resize(api::compute_size(count));
+            check(api::impl::detail::get_vars(ncid(), varid_, lower.data(), count.data(), unit.data(), buffer.data()));
+
+            // Scatter to the output in request order.
+            for (auto it = first; it != last; ++it) {
+                p = &points[it->second * ndims];
+                std::size_t offset = 0;
+                for (std::size_t d = 0; d < ndims; ++d)
+                    offset = offset * count[d] + (p[d] - lower[d]);
+                out[it->second] = buffer[offset];
+            }
+
+            first = last;
+        }
+    }
+
+    /// Get values at a list of indexes within the selection, in request order.
+    template <class T, class A = std::allocator<T>>
+    std::vector<T, A> gather(const std::vector<index_type>& indexes) const
+    {
+        std::vector<T, A> result(indexes.size());
+        gather(indexes, result.data());
+        return result;
     }
 
     /// Get values as std::vector.
     template <class T, class A = std::allocator<T>>
     std::vector<T, A> values() const
     {
-        return api::get_vars<std::vector<T, A>>(ncid_, varid_, start_, shape_, stride_);
+        return api::get_vars<std::vector<T, A>>(ncid(), varid_, start_, shape_, stride_);
+    }
+
+    /// Copy values to allocated memory, with a validity bitmap of at least
+    /// (size() + 63) / 64 words. Values are tested with mask() as they are
+    /// read, one chunk at a time.
+    template <class T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type read_masked(T *out, std::uint64_t *valid) const
+    {
+        const auto mask = this->mask<T>();
+        std::fill_n(valid, (size() + 63) / 64, std::uint64_t(0));
+
+        std::vector<T> buffer;
+        std::vector<unsigned char> flags;
+        auto it = chunks();
+        while (it.next()) {
+            it.read(buffer);
+
+            api::for_each_row(it.position(), it.count(), shape_,
+                [&](std::size_t src, std::size_t dst, std::size_t n) {
+                    flags.resize(n);
+                    mask.validate(buffer.data() + src, n, flags.data());
+                    detail::pack_bits(flags.data(), n, valid, dst);
+                    std::copy_n(buffer.data() + src, n, out + dst);
+                });
+        }
+    }
+
+    /// Get values with a validity bitmap.
+    template <class T, class A = std::allocator<T>>
+    typename std::enable_if<std::is_arithmetic<T>::value, masked_array<T, A>>::type values_masked() const
+    {
+        masked_array<T, A> result;
+        result.data.resize(size());
+        result.valid.resize((size() + 63) / 64);
+        read_masked(result.data.data(), result.valid.data());
+        return result;
+    }
+
+    /// Copy values to allocated memory, unpacked using the CF scale_factor
+    /// and add_offset attributes. Signed integer types with an _Unsigned
+    /// attribute are read as unsigned. Packed values that fail mask() are
+    /// set to NaN. Packed values are read one chunk at a time.
+    template <class T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type read_decoded(T *out) const
+    {
+        const T scale = atts.contains("scale_factor") ? atts["scale_factor"].value<T>() : T(1);
+        const T offset = atts.contains("add_offset") ? atts["add_offset"].value<T>() : T(0);
+        const bool is_unsigned = atts.contains("_Unsigned") &&
+                                 atts["_Unsigned"].value<std::string>() == "true";
+
+        switch (netcdf_type()) {
+        case NC_BYTE:
+            return is_unsigned ? read_unpacked<signed char, unsigned char>(out, scale, offset)
+                               : read_unpacked<signed char, signed char>(out, scale, offset);
+        case NC_SHORT:
+            return is_unsigned ? read_unpacked<short, unsigned short>(out, scale, offset)
+                               : read_unpacked<short, short>(out, scale, offset);
+        case NC_INT:
+            return is_unsigned ? read_unpacked<int, unsigned int>(out, scale, offset)
+                               : read_unpacked<int, int>(out, scale, offset);
+        case NC_INT64:
+            return is_unsigned ? read_unpacked<long long, unsigned long long>(out, scale, offset)
+                               : read_unpacked<long long, long long>(out, scale, offset);
+        case NC_UBYTE:  return read_unpacked<unsigned char, unsigned char>(out, scale, offset);
+        case NC_USHORT: return read_unpacked<unsigned short, unsigned short>(out, scale, offset);
+        case NC_UINT:   return read_unpacked<unsigned int, unsigned int>(out, scale, offset);
+        case NC_UINT64: return read_unpacked<unsigned long long, unsigned long long>(out, scale, offset);
+        case NC_FLOAT:  return read_unpacked<float, float>(out, scale, offset);
+        case NC_DOUBLE: return read_unpacked<double, double>(out, scale, offset);
+        default:
+            detail::throw_error(error::invalid_data_type);
+        }
+    }
+
+    /// Get values as std::vector, unpacked using the CF scale_factor and
+    /// add_offset attributes, with NaN for invalid values.
+    template <class T, class A = std::allocator<T>>
+    typename std::enable_if<std::is_floating_point<T>::value, std::vector<T, A>>::type values_decoded() const
+    {
+        std::vector<T, A> result(size());
+        read_decoded(result.data());
+        return result;
+    }
+
+    /// Compute statistics over the selection. Values are unpacked using the
+    /// CF scale_factor and add_offset attributes, and values that fail the
+    /// mask are skipped. Values are read one chunk at a time.
+    statistics reduce() const
+    {
+        return reduce_along(std::vector<bool>(shape_.size(), true)).front();
+    }
+
+    /// Compute statistics along the named dimensions. Returns one result for
+    /// each element of the remaining dimensions, in row-major order.
+    std::vector<statistics> reduce(const std::vector<std::string>& dimnames) const
+    {
+        std::vector<bool> reduced(shape_.size(), false);
+        for (const auto& dimname : dimnames) {
+            auto n = dims.position(dimname);
+            if (!n.has_value())
+                detail::throw_error(error::invalid_dimension);
+            reduced[n.value()] = true;
+        }
+        return reduce_along(reduced);
+    }
+
+    /// Compute statistics over the selection on a thread pool. The calling
+    /// thread reads the blocks; results do not depend on the pool size.
+    statistics reduce(thread_pool& pool) const
+    {
+        return reduce_along(std::vector<bool>(shape_.size(), true), pool).front();
+    }
+
+    /// Compute statistics along the named dimensions on a thread pool.
+    std::vector<statistics> reduce(const std::vector<std::string>& dimnames, thread_pool& pool) const
+    {
+        std::vector<bool> reduced(shape_.size(), false);
+        for (const auto& dimname : dimnames) {
+            auto n = dims.position(dimname);
+            if (!n.has_value())
+                detail::throw_error(error::invalid_dimension);
+            reduced[n.value()] = true;
+        }
+        return reduce_along(reduced, pool);
+    }
+
+    /// Read the selection one chunk at a time on the calling thread, and call
+    /// compute(block) for each block on a thread pool. If compute returns a
+    /// value, combine(value) is called on the calling thread in block order.
+    /// At most two blocks per worker are held in memory. Blocks are read
+    /// while holding detail::netcdf_lock.
+    template <class T, class F, class G>
+    void for_each_block(thread_pool& pool, F compute, G combine) const
+    {
+        using result_type = std::invoke_result_t<F&, const block<T>&>;
+
+        const std::size_t depth = 2 * pool.size();
+        std::deque<std::future<result_type>> pending;
+        auto pop = [&] {
+            if constexpr (std::is_void<result_type>::value) {
+                pending.front().get();
+            }
+            else {
+                combine(pending.front().get());
+            }
+            pending.pop_front();
+        };
+
+        try {
+            auto it = chunks();
+            while (it.next()) {
+                auto b = std::make_shared<block<T>>();
+                b->offset = it.offset() - it.block_size();
+                b->start = it.start();
+                b->position = it.position();
+                b->count = it.count();
+                {
+                    detail::netcdf_lock lock;
+                    it.read(b->data);
+                }
+
+                pending.emplace_back(pool.submit([b, &compute] { return compute(*b); }));
+                if (pending.size() >= depth)
+                    pop();
+            }
+            while (!pending.empty())
+                pop();
+        }
+        catch (...) {
+            // Tasks refer to compute, so wait for them before unwinding.
+            for (auto& f : pending)
+                f.wait();
+            throw;
+        }
+    }
+
+    /// Call compute(block) for each block on a thread pool.
+    template <class T, class F>
+    void for_each_block(thread_pool& pool, F compute) const
+    {
+        for_each_block<T>(pool, std::move(compute), [](auto&&) {});
+    }
+
+    /// Get values with f applied to each value, computed on a thread pool.
+    template <class T, class F, class A = std::allocator<T>>
+    std::vector<T, A> transform(F f, thread_pool& pool) const
+    {
+        std::vector<T, A> result(size());
+        T *out = result.data();
+        for_each_block<T>(pool, [&](const block<T>& b) {
+            api::for_each_row(b.position, b.count, shape_,
+                [&](std::size_t src, std::size_t dst, std::size_t n) {
+                    for (std::size_t k = 0; k < n; ++k)
+                        out[dst + k] = f(b.data[src + k]);
+                });
+        });
+        return result;
     }
     
 #ifdef NCPP_USE_BOOST
@@ -378,7 +937,7 @@ public:
         std::copy_n(shape_.begin(), N, extents.begin());
         boost::multi_array<T, N, A> result(extents, boost::fortran_storage_order{});
 
-        check(api::impl::detail::get_vars(ncid_, varid_, start_.data(), shape_.data(), stride_.data(), result.data()));
+        check(api::impl::detail::get_vars(ncid(), varid_, start_.data(), shape_.data(), stride_.data(), result.data()));
         return result;
     }
 
@@ -386,19 +945,269 @@ public:
     template <class T, class A = std::allocator<T>>
     typename std::enable_if<std::is_arithmetic<T>::value, matrix_type<T, A>>::type matrix() const
     {
-        auto extents = detail::squeeze(shape_);
+        auto extents = api::squeeze(shape_);
         if (extents.size() != 2)
             detail::throw_error(error::invalid_coordinates); // NC_EINVALCOORDS
         
         matrix_type<T, A> result(extents[0], extents[1]);
-        check(api::impl::detail::get_vars(ncid_, varid_, start_.data(), shape_.data(), stride_.data(), result.data().begin()));
+        check(api::impl::detail::get_vars(ncid(), varid_, start_.data(), shape_.data(), stride_.data(), result.data().begin()));
         return result;
     }
 
 #endif // NCPP_USE_BOOST
 
+    // The asynchronous members are defined in io_service.hpp, which is
+    // included at the end of this header, so they are available wherever
+    // variable is.
+
+    /// \group async
+    /// Get values asynchronously on the shared I/O service.
+    template <class T, class A = std::allocator<T>>
+    std::future<std::vector<T, A>> values_async(const cancellation& c = cancellation()) const;
+
+    /// \group async
+    /// Get values asynchronously, then invoke a callback on the I/O thread
+    /// with an exception pointer (null on success) and the values.
+    template <class T, class A = std::allocator<T>, class F,
+              class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, cancellation>>>
+    void values_async(F&& callback, const cancellation& c = cancellation()) const;
+
+    /// \group async
+    /// Copy values asynchronously to allocated memory, which must remain
+    /// valid until the future is ready.
+    template <class T>
+    std::future<void> read_async(T *out, const cancellation& c = cancellation()) const;
+
+    /// \group async
+    /// Get the coordinates for a dimension asynchronously.
+    template <class T>
+    std::future<std::vector<T>> coordinates_async(std::size_t pos, const cancellation& c = cancellation()) const;
+
+#ifdef NCPP_USE_BOOST
+
+    /// \group async
+    template <class T, std::size_t N, class A = std::allocator<T>>
+    std::future<multi_array_type<T, N, A>> multi_array_async(const cancellation& c = cancellation()) const;
+
+    /// \group async
+    template <class T, class A = std::allocator<T>>
+    std::future<matrix_type<T, A>> matrix_async(const cancellation& c = cancellation()) const;
+
+#endif // NCPP_USE_BOOST
+
+    /// Get the metadata snapshot shared with the dataset.
+    const std::shared_ptr<const metadata>& meta() const {
+        return meta_;
+    }
+
 private:
-    int ncid_;
+    // Get the valid data test with attributes read as type U and converted
+    // to type V.
+    template <class U, class V>
+    value_mask<V> load_mask() const
+    {
+        value_mask<V> mask;
+        if (atts.contains("_FillValue")) {
+            mask.fill_value = static_cast<V>(atts["_FillValue"].value<U>());
+        }
+        else if (sizeof(U) > 1) {
+            std::error_code ec;
+            auto fill = api::inq_var_fill<U>(ncid(), varid_, ec);
+            if (!ec && fill.has_value())
+                mask.fill_value = static_cast<V>(fill.value());
+        }
+
+        if (atts.contains("missing_value")) {
+            auto missing = atts["missing_value"].values<U>();
+            if (!missing.empty())
+                mask.missing_value = static_cast<V>(missing.front());
+        }
+
+        if (atts.contains("valid_range")) {
+            auto range = atts["valid_range"].values<U>();
+            if (range.size() == 2) {
+                mask.valid_min = static_cast<V>(range[0]);
+                mask.valid_max = static_cast<V>(range[1]);
+            }
+        }
+
+        if (atts.contains("valid_min"))
+            mask.valid_min = static_cast<V>(atts["valid_min"].value<U>());
+        if (atts.contains("valid_max"))
+            mask.valid_max = static_cast<V>(atts["valid_max"].value<U>());
+
+        return mask;
+    }
+
+    // Get the valid data test for the storage type, converted to double.
+    value_mask<double> storage_mask() const
+    {
+        switch (netcdf_type()) {
+        case NC_BYTE:   return load_mask<signed char, double>();
+        case NC_SHORT:  return load_mask<short, double>();
+        case NC_INT:    return load_mask<int, double>();
+        case NC_INT64:  return load_mask<long long, double>();
+        case NC_UBYTE:  return load_mask<unsigned char, double>();
+        case NC_USHORT: return load_mask<unsigned short, double>();
+        case NC_UINT:   return load_mask<unsigned int, double>();
+        case NC_UINT64: return load_mask<unsigned long long, double>();
+        case NC_FLOAT:  return load_mask<float, double>();
+        case NC_DOUBLE: return load_mask<double, double>();
+        default:
+            detail::throw_error(error::invalid_data_type);
+            return {};
+        }
+    }
+
+    // Get the row-major strides of a reduction result over shape, with zero
+    // strides for reduced dimensions. Returns the result size.
+    static std::size_t reduce_strides(const index_type& shape, const std::vector<bool>& reduced, index_type& strides)
+    {
+        strides.assign(shape.size(), 0);
+        std::size_t n = 1;
+        for (std::size_t i = shape.size(); i != 0; --i) {
+            if (!reduced[i-1]) {
+                strides[i-1] = n;
+                n *= shape[i-1];
+            }
+        }
+        return n;
+    }
+
+    // Accumulate the valid values of a block at position within an array of
+    // the given shape into a reduction result with the given strides.
+    static void accumulate_block(const double *data, const index_type& position, const index_type& count,
+                                 const index_type& shape, const index_type& strides,
+                                 const value_mask<double>& mask, statistics *result)
+    {
+        const std::size_t ndims = shape.size();
+        const bool by_row = (ndims == 0 || strides.back() == 0);
+
+        std::vector<unsigned char> flags;
+        api::for_each_row(position, count, shape,
+            [&](std::size_t src, std::size_t dst, std::size_t len) {
+                flags.resize(len);
+                mask.validate(data + src, len, flags.data());
+
+                // Map the start of the row to the result.
+                std::size_t pos = 0;
+                for (std::size_t i = ndims; i != 0; --i) {
+                    pos += (dst % shape[i-1]) * strides[i-1];
+                    dst /= shape[i-1];
+                }
+
+                if (by_row) {
+                    result[pos].accumulate(data + src, flags.data(), len);
+                }
+                else {
+                    for (std::size_t k = 0; k < len; ++k)
+                        result[pos + k].accumulate(data + src + k, flags.data() + k, 1);
+                }
+            });
+    }
+
+    // Apply scale_factor and add_offset to reduction results.
+    void unpack_statistics(std::vector<statistics>& result) const
+    {
+        const double scale = atts.contains("scale_factor") ? atts["scale_factor"].value<double>() : 1.0;
+        const double offset = atts.contains("add_offset") ? atts["add_offset"].value<double>() : 0.0;
+        if (scale != 1.0 || offset != 0.0) {
+            for (auto& stats : result)
+                stats.transform(scale, offset);
+        }
+    }
+
+    // Compute statistics along the flagged dimensions, one chunk at a time.
+    std::vector<statistics> reduce_along(const std::vector<bool>& reduced) const
+    {
+        index_type strides;
+        std::vector<statistics> result(reduce_strides(shape_, reduced, strides));
+        const auto mask = storage_mask();
+
+        std::vector<double> buffer;
+        auto it = chunks();
+        while (it.next()) {
+            it.read(buffer);
+            accumulate_block(buffer.data(), it.position(), it.count(), shape_, strides, mask, result.data());
+        }
+
+        unpack_statistics(result);
+        return result;
+    }
+
+    // Compute statistics along the flagged dimensions on a thread pool. Each
+    // block is reduced into a partial result over the block extent of the
+    // remaining dimensions, and partial results are merged in block order.
+    std::vector<statistics> reduce_along(const std::vector<bool>& reduced, thread_pool& pool) const
+    {
+        index_type strides;
+        std::vector<statistics> result(reduce_strides(shape_, reduced, strides));
+        const auto mask = storage_mask();
+        const std::size_t ndims = shape_.size();
+
+        struct partial {
+            index_type position;
+            index_type count;
+            index_type strides;
+            std::vector<statistics> values;
+        };
+
+        for_each_block<double>(pool,
+            [&](const block<double>& b) {
+                partial p{ b.position, b.count, {}, {} };
+                p.values.resize(reduce_strides(b.count, reduced, p.strides));
+                accumulate_block(b.data.data(), index_type(ndims, 0), b.count, b.count, p.strides, mask, p.values.data());
+                return p;
+            },
+            [&](const partial& p) {
+                // Merge the partial result, iterating over the block extent of
+                // the remaining dimensions in row-major order.
+                index_type index(ndims, 0);
+                for (const auto& stats : p.values) {
+                    std::size_t pos = 0;
+                    for (std::size_t i = 0; i < ndims; ++i)
+                        pos += (p.position[i] + index[i]) * strides[i];
+                    result[pos].merge(stats);
+
+                    for (std::size_t i = ndims; i != 0; --i) {
+                        if (reduced[i-1])
+                            continue;
+                        if (++index[i-1] < p.count[i-1])
+                            break;
+                        index[i-1] = 0;
+                    }
+                }
+            });
+
+        unpack_statistics(result);
+        return result;
+    }
+
+    // Read packed values with storage type U one chunk at a time into a
+    // reused buffer, reinterpret them as V and unpack them into the output.
+    template <class U, class V, class T>
+    void read_unpacked(T *out, T scale, T offset) const
+    {
+        static_assert(sizeof(U) == sizeof(V), "packed types must have the same size");
+
+        const auto mask = load_mask<U, V>();
+        std::vector<U> buffer;
+        std::vector<unsigned char> flags;
+        auto it = chunks();
+        while (it.next()) {
+            it.read(buffer);
+
+            const V *in = reinterpret_cast<const V *>(buffer.data());
+            api::for_each_row(it.position(), it.count(), shape_,
+                [&](std::size_t src, std::size_t dst, std::size_t n) {
+                    flags.resize(n);
+                    mask.validate(in + src, n, flags.data());
+                    detail::unpack_masked(in + src, n, scale, offset, flags.data(), out + dst);
+                });
+        }
+    }
+
+    std::shared_ptr<const metadata> meta_;
     int varid_;
     std::vector<std::size_t> start_;
     std::vector<std::size_t> shape_;
@@ -411,4 +1220,9 @@ private:
 #pragma warning(pop)
 #endif // defined(NCPP_USE_BOOST) && defined(_MSVC_LANG) && _MSVC_LANG >= 201402L
 
+// Defines the members of variable that return an indexed_variable, and
+// the asynchronous members.
+#include <ncpp/indexed_variable.hpp>
+#include <ncpp/io_service.hpp>
+
 #endif // NCPP_VARIABLE_HPP
@@ -15,109 +15,98 @@
 
 #include <ncpp/config.hpp>
 
+#include <ncpp/detail/view_iterator.hpp>
+#include <ncpp/metadata.hpp>
 #include <ncpp/variable.hpp>
 #include <ncpp/check.hpp>
 
-#include <iterator>
-#include <set>
+#include <memory>
 #include <string>
-#include <vector>
+#include <string_view>
+#include <utility>
 
 namespace ncpp {
 
 class dataset;
 
-/// netCDF variable set.
+/// netCDF variable sequence container, in variable ID order.
 class variables_type
 {
     friend class dataset;
+    friend class detail::view_iterator<variables_type>;
 
 public:
-    using storage_type = std::set<variable>;
-    using value_type = typename storage_type::value_type;
-    using iterator = storage_type::iterator;
-    using const_iterator = storage_type::const_iterator;
-    using reference = storage_type::reference;
-    using const_reference = storage_type::const_reference;
-
-    explicit variables_type(int ncid)
-        : ncid_(ncid)
-    {
-        auto varids = api::inq_varids(ncid);
-        for (const auto& varid : varids)
-            vars_.emplace(variable(ncid, varid));
-    }
-    
-    iterator begin() noexcept {
-        return vars_.begin();
-    }
-
-    iterator end() noexcept {
-        return vars_.end();
-    }
+    using value_type = variable;
+    using iterator = detail::view_iterator<variables_type>;
+    using const_iterator = iterator;
+    using reference = value_type;
+    using const_reference = value_type;
+
+    explicit variables_type(std::shared_ptr<const metadata> meta)
+        : meta_(std::move(meta))
+    {}
     
-    const_iterator begin() const noexcept {
-        return vars_.begin();
+    const_iterator begin() const {
+        return const_iterator(this, 0);
     }
 
-    const_iterator end() const noexcept {
-        return vars_.end();
+    const_iterator end() const {
+        return const_iterator(this, size());
     }
 
     const_reference front() const {
-        return *vars_.cbegin();
+        return get(0);
     }
 
     const_reference back() const {
-        return *vars_.cend();
+        return get(size() - 1);
     }
 
-    std::size_t size() const noexcept {
-        return vars_.size();
+    std::size_t size() const {
+        return meta_->nvars();
     }
 
-    bool empty() const noexcept {
-        return vars_.empty();
+    bool empty() const {
+        return meta_->nvars() == 0;
     }
 
     /// Get a variable by name.
-    const_reference operator[](const std::string& name) const
+    const_reference operator[](std::string_view name) const
     {
-        auto varid = api::inq_varid(ncid_, name);
+        auto varid = meta_->find_var(name);
         if (!varid.has_value())
             detail::throw_error(error::variable_not_found);
         
-        const auto it = vars_.find(variable(ncid_, varid.value()));
-        if (it == vars_.end())
-            detail::throw_error(error::variable_not_found);
-        
-        return *it;
+        return variable(meta_, varid.value());
     }
 
     /// Get a variable by index.
     const_reference at(std::size_t n) const
     {
-        if (n >= vars_.size())
+        if (n >= size())
             detail::throw_error(error::variable_not_found);
 
-        return *std::next(vars_.begin(), n);
+        return get(n);
     }
 
     /// Determine if a variable is present.
-    bool contains(const std::string& name) const noexcept
+    bool contains(std::string_view name) const noexcept
     {
-        std::error_code ec;
-        auto varid = api::inq_varid(ncid_, name, ec);
-        if (ec.value() || !varid.has_value())
+        try {
+            return meta_->find_var(name).has_value();
+        }
+        catch (...) {
             return false;
-        
-        const auto it = std::find(vars_.begin(), vars_.end(), variable(ncid_, varid.value()));
-        return (it != vars_.end());
+        }
     }
 
 private:
-    int ncid_;
-    storage_type vars_;
+    value_type get(std::size_t n) const
+    {
+        return variable(meta_, meta_->varid(n));
+    }
+
+    std::shared_ptr<const metadata> meta_;
 };
 
 } // namespace ncpp
@@ -0,0 +1,82 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <ncpp/ncpp.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Measures the latency of opening a dataset, resolving a single variable
+// and materializing all dimension and attribute metadata.
+
+int main(int argc, char *argv[])
+{
+    using clock = std::chrono::steady_clock;
+    using microseconds = std::chrono::duration<double, std::micro>;
+
+    std::string filename;
+    if (argc > 1)
+        filename = argv[1];
+    else
+        filename = "./data/ECMWF_ERA-40_subset.nc";
+
+    int iterations = (argc > 2) ? std::atoi(argv[2]) : 10;
+    if (iterations <= 0)
+        iterations = 1;
+
+    microseconds t_open{0}, t_lookup{0}, t_metadata{0};
+    std::size_t nvars = 0, ndims = 0, natts = 0;
+
+    try {
+        // Name of the last variable, resolved by name on each iteration.
+        std::string varname;
+        {
+            ncpp::file f(filename, ncpp::file::read);
+            auto varids = ncpp::api::inq_varids(f.ncid());
+            if (!varids.empty())
+                varname = ncpp::api::inq_varname(f.ncid(), varids.back());
+        }
+
+        for (int i = 0; i < iterations; ++i) {
+            auto t0 = clock::now();
+            ncpp::file f(filename, ncpp::file::read);
+            ncpp::dataset ds(f);
+            auto t1 = clock::now();
+
+            if (!varname.empty())
+                (void)ds.vars[varname];
+            auto t2 = clock::now();
+
+            // Touch every dimension and attribute.
+            nvars = ndims = natts = 0;
+            for (const auto& v : ds.vars) {
+                ndims += v.dims.size();
+                natts += v.atts.size();
+                ++nvars;
+            }
+            natts += ds.atts.size();
+            auto t3 = clock::now();
+
+            t_open += t1 - t0;
+            t_lookup += t2 - t1;
+            t_metadata += t3 - t2;
+        }
+    }
+    catch (std::system_error& e) {
+        std::cerr << e.code() << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << filename << ": " << nvars << " variables, "
+              << ndims << " variable dimensions, " << natts << " attributes\n";
+    std::cout << "open:     " << t_open.count() / iterations << " us\n";
+    std::cout << "lookup:   " << t_lookup.count() / iterations << " us\n";
+    std::cout << "metadata: " << t_metadata.count() / iterations << " us\n";
+
+    return 0;
+}
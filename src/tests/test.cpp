@@ -0,0 +1,1097 @@
+// Copyright (c) 2020 John Buonagurio (jbuonagurio at exponent dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <netcdf.h>
+
+#include <ncpp/ncpp.hpp>
+#include <ncpp/classic_file.hpp>
+#include <ncpp/coordinate_view.hpp>
+#include <ncpp/spatial_index.hpp>
+#include <ncpp/detail/kernels.hpp>
+#include <ncpp/detail/utilities.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char *what)
+{
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+// Run a test, counting an exception as a failure.
+void run(void (*test)(), const char *name)
+{
+    try {
+        test();
+    }
+    catch (std::exception& e) {
+        std::cerr << "FAILED: " << name << ": " << e.what() << "\n";
+        ++failures;
+    }
+}
+
+// Test datasets are created in memory with the netCDF-C API.
+
+int define_dimension(int ncid, const char *name, std::size_t len)
+{
+    int dimid;
+    ncpp::check(nc_def_dim(ncid, name, len, &dimid));
+    return dimid;
+}
+
+int define_variable(int ncid, const char *name, nc_type type, const std::vector<int>& dimids)
+{
+    int varid;
+    ncpp::check(nc_def_var(ncid, name, type, static_cast<int>(dimids.size()), dimids.data(), &varid));
+    return varid;
+}
+
+void put_text(int ncid, int varid, const char *name, const char *value)
+{
+    ncpp::check(nc_put_att_text(ncid, varid, name, std::strlen(value), value));
+}
+
+#ifdef NCPP_USE_DATE_H
+
+// Six-hourly time coordinate with a data variable.
+ncpp::file make_time_file()
+{
+    auto f = ncpp::file::create_memory("time");
+    const int ncid = f.ncid();
+
+    const int time = define_dimension(ncid, "time", 8);
+    const int x = define_dimension(ncid, "x", 3);
+    const int time_id = define_variable(ncid, "time", NC_DOUBLE, { time });
+    const int tcw_id = define_variable(ncid, "tcw", NC_FLOAT, { time, x });
+    put_text(ncid, time_id, "units", "hours since 2002-07-01 00:00:00");
+    put_text(ncid, time_id, "calendar", "gregorian");
+    ncpp::check(nc_enddef(ncid));
+
+    std::vector<double> hours(8);
+    std::vector<float> tcw(8 * 3);
+    for (std::size_t n = 0; n < hours.size(); ++n)
+        hours[n] = 6.0 * static_cast<double>(n);
+    for (std::size_t n = 0; n < tcw.size(); ++n)
+        tcw[n] = static_cast<float>(n);
+    ncpp::check(nc_put_var_double(ncid, time_id, hours.data()));
+    ncpp::check(nc_put_var_float(ncid, tcw_id, tcw.data()));
+    return f;
+}
+
+// Nearest-value selection on a time coordinate, with a duration tolerance.
+void test_nearest_time()
+{
+    auto f = make_time_file();
+    ncpp::dataset ds(f);
+
+    auto tcw = ds.vars["tcw"];
+    auto times = ds.vars["time"].values<date::sys_seconds>();
+    expect(times.size() == 8, "time coordinate has eight values");
+    if (times.size() != 8)
+        return;
+
+    const auto step = times[2] - times[1];
+    const auto tolerance = step / 2;
+    expect(step == std::chrono::hours(6), "time step from units");
+
+    expect(tcw.nearest("time", times[1] + step / 4) == 1, "nearest without tolerance");
+    expect(tcw.nearest("time", times[1] + step / 4, tolerance) == 1, "nearest within tolerance");
+    expect(tcw.nearest("time", std::vector<date::sys_seconds>{ times[2], times[0] }, tolerance) ==
+           ncpp::index_type{ 2, 0 }, "nearest for several targets");
+
+    bool thrown = false;
+    try {
+        tcw.nearest("time", times.back() + step, tolerance);
+    }
+    catch (std::system_error&) {
+        thrown = true;
+    }
+    expect(thrown, "nearest outside tolerance throws");
+
+    auto slice = tcw.select(
+        ncpp::nearest_selection<date::sys_seconds>{"time", { times[2] - step / 4, times[0] }, tolerance}
+    );
+    expect(slice.shape().at(0) == 2, "select nearest time values");
+    expect(slice.size() == 2 * tcw.size() / times.size(), "select nearest size");
+    expect(slice.values<float>() == std::vector<float>{ 6, 7, 8, 0, 1, 2 }, "select nearest values");
+}
+
+#endif // NCPP_USE_DATE_H
+
+// Chunked netCDF-4 grid with coordinates equal to their indexes. Each value
+// of "values" is its linear offset, and "scalar" is a scalar variable.
+ncpp::file make_grid_file()
+{
+    auto f = ncpp::file::create_memory("grid");
+    const int ncid = f.ncid();
+
+    const std::size_t shape[] = { 6, 10, 12 };
+    const int dims[] = {
+        define_dimension(ncid, "time", shape[0]),
+        define_dimension(ncid, "y", shape[1]),
+        define_dimension(ncid, "x", shape[2])
+    };
+    const char *names[] = { "time", "y", "x" };
+    int coords[3];
+    for (int d = 0; d < 3; ++d)
+        coords[d] = define_variable(ncid, names[d], NC_DOUBLE, { dims[d] });
+
+    const std::size_t chunks[] = { 2, 4, 5 };
+    const int values_id = define_variable(ncid, "values", NC_INT, { dims[0], dims[1], dims[2] });
+    ncpp::check(nc_def_var_chunking(ncid, values_id, NC_CHUNKED, chunks));
+    const int scalar_id = define_variable(ncid, "scalar", NC_INT, {});
+    ncpp::check(nc_enddef(ncid));
+
+    for (int d = 0; d < 3; ++d) {
+        std::vector<double> c(shape[d]);
+        for (std::size_t n = 0; n < c.size(); ++n)
+            c[n] = static_cast<double>(n);
+        ncpp::check(nc_put_var_double(ncid, coords[d], c.data()));
+    }
+
+    std::vector<int> values(shape[0] * shape[1] * shape[2]);
+    for (std::size_t n = 0; n < values.size(); ++n)
+        values[n] = static_cast<int>(n);
+    ncpp::check(nc_put_var_int(ncid, values_id, values.data()));
+
+    const int scalar = 42;
+    ncpp::check(nc_put_var_int(ncid, scalar_id, &scalar));
+    return f;
+}
+
+// Select a region of a grid variable by inclusive index ranges.
+ncpp::variable region(const ncpp::variable& v, double t0, double t1, double y0, double y1,
+                      double x0, double x1, std::ptrdiff_t xstride = 1)
+{
+    return v.select(ncpp::selection<double>{"time", t0, t1},
+                    ncpp::selection<double>{"y", y0, y1},
+                    ncpp::selection<double>{"x", x0, x1, xstride});
+}
+
+// Classic format dataset with coordinate, fixed and record variables. The
+// record dimension has four records. Variables of five shorts are padded
+// to four bytes, except the records of a single record variable.
+ncpp::memory_buffer make_classic_file(int cmode, bool several_records)
+{
+    auto f = ncpp::file::create_memory("classic", 0, cmode);
+    const int ncid = f.ncid();
+
+    const int time = define_dimension(ncid, "time", NC_UNLIMITED);
+    const int y = define_dimension(ncid, "y", 3);
+    const int x = define_dimension(ncid, "x", 5);
+    put_text(ncid, NC_GLOBAL, "title", "classic format test");
+    const int y_id = define_variable(ncid, "y", NC_DOUBLE, { y });
+    const int x_id = define_variable(ncid, "x", NC_DOUBLE, { x });
+    const int grid_id = define_variable(ncid, "grid", NC_DOUBLE, { y, x });
+    const int flags_id = define_variable(ncid, "flags", NC_SHORT, { x });
+    const int rec_id = define_variable(ncid, "rec", NC_SHORT, { time, x });
+    put_text(ncid, rec_id, "units", "m");
+    int temp_id = -1, count_id = -1;
+    if (several_records) {
+        temp_id = define_variable(ncid, "temp", NC_FLOAT, { time, y, x });
+        count_id = define_variable(ncid, "count", NC_INT, { time });
+    }
+    ncpp::check(nc_enddef(ncid));
+
+    const std::vector<double> yc{ 0, 1, 2 }, xc{ 0, 1, 2, 3, 4 };
+    std::vector<double> grid(15);
+    std::vector<short> flags(5), rec(4 * 5);
+    std::vector<float> temp(4 * 15);
+    std::vector<int> count(4);
+    for (std::size_t n = 0; n < grid.size(); ++n)
+        grid[n] = 0.5 * static_cast<double>(n);
+    for (std::size_t n = 0; n < flags.size(); ++n)
+        flags[n] = static_cast<short>(n) - 2;
+    for (std::size_t n = 0; n < rec.size(); ++n)
+        rec[n] = static_cast<short>(100 * (n / 5) + n % 5);
+    for (std::size_t n = 0; n < temp.size(); ++n)
+        temp[n] = 1000.0f * static_cast<float>(n / 15) + static_cast<float>(n % 15);
+    for (std::size_t n = 0; n < count.size(); ++n)
+        count[n] = static_cast<int>(n) + 1;
+
+    ncpp::check(nc_put_var_double(ncid, y_id, yc.data()));
+    ncpp::check(nc_put_var_double(ncid, x_id, xc.data()));
+    ncpp::check(nc_put_var_double(ncid, grid_id, grid.data()));
+    ncpp::check(nc_put_var_short(ncid, flags_id, flags.data()));
+
+    const std::size_t start[] = { 0, 0, 0 };
+    const std::size_t rec_count[] = { 4, 5 }, temp_count[] = { 4, 3, 5 }, count_count[] = { 4 };
+    ncpp::check(nc_put_vara_short(ncid, rec_id, start, rec_count, rec.data()));
+    if (several_records) {
+        ncpp::check(nc_put_vara_float(ncid, temp_id, start, temp_count, temp.data()));
+        ncpp::check(nc_put_vara_int(ncid, count_id, start, count_count, count.data()));
+    }
+    return f.close_memory();
+}
+
+// Compare classic_file reads and views of a variable with the netCDF-C
+// library, including a strided selection and each record.
+template <class T>
+void check_classic_variable(const ncpp::classic_file& cf, const ncpp::variable& var, const std::string& what)
+{
+    const auto expected = var.values<T>();
+    expect(cf.values<T>(var) == expected, (what + ": read").c_str());
+
+    if (var.dims.contains("x")) {
+        auto sub = var.select(ncpp::selection<double>{"x", 1, 4, 2});
+        expect(cf.values<T>(sub) == sub.values<T>(), (what + ": strided read").c_str());
+    }
+
+    const auto& info = cf.at(var.name());
+    std::size_t nrecvars = 0;
+    for (const auto& v : cf.variables())
+        nrecvars += v.is_record;
+
+    if (!info.is_record || nrecvars == 1)
+        expect(cf.view<T>(var.name()).values() == expected, (what + ": view").c_str());
+    else {
+        bool thrown = false;
+        try {
+            cf.view<T>(var.name());
+        }
+        catch (std::system_error&) {
+            thrown = true;
+        }
+        expect(thrown, (what + ": view of one of several record variables throws").c_str());
+    }
+
+    if (info.is_record) {
+        for (std::size_t r = 0; r < cf.numrecs(); ++r) {
+            auto record = var.isel("time", { r }).values<T>();
+            expect(cf.view<T>(var.name(), r).values() == record, (what + ": record view").c_str());
+        }
+    }
+}
+
+void check_classic_file(int cmode, int version, bool several_records)
+{
+    const std::string what = "CDF-" + std::to_string(version) +
+        (several_records ? " with several record variables" : " with one record variable");
+
+    auto buffer = make_classic_file(cmode, several_records);
+    ncpp::classic_file cf(buffer.data(), buffer.size());
+    auto f = ncpp::file::open_memory(buffer.data(), buffer.size(), "classic");
+    ncpp::dataset ds(f);
+
+    expect(cf.version() == version, (what + ": version").c_str());
+    expect(cf.numrecs() == 4, (what + ": numrecs").c_str());
+    expect(cf.variables().size() == ds.vars.size(), (what + ": number of variables").c_str());
+
+    check_classic_variable<double>(cf, ds.vars["grid"], what + " grid");
+    check_classic_variable<short>(cf, ds.vars["flags"], what + " flags");
+    check_classic_variable<short>(cf, ds.vars["rec"], what + " rec");
+    if (several_records) {
+        check_classic_variable<float>(cf, ds.vars["temp"], what + " temp");
+        check_classic_variable<int>(cf, ds.vars["count"], what + " count");
+    }
+
+    // A streamed file has numrecs set to all ones, and the number of records
+    // is inferred from the file size.
+    std::vector<unsigned char> streamed(buffer.data(), buffer.data() + buffer.size());
+    std::fill_n(streamed.begin() + 4, version == 5 ? 8 : 4, std::uint8_t(0xFF));
+    ncpp::classic_file scf(streamed.data(), streamed.size());
+    expect(scf.numrecs() == 4, (what + ": streaming numrecs").c_str());
+    check_classic_variable<short>(scf, ds.vars["rec"], what + " streamed rec");
+}
+
+// Header decoding, big-endian views, strided reads and record padding of
+// classic_file, in each classic format.
+void test_classic_file()
+{
+    const std::pair<int, int> formats[] = { { 0, 1 }, { NC_64BIT_OFFSET, 2 }, { NC_64BIT_DATA, 5 } };
+    for (const auto& format : formats) {
+        check_classic_file(format.first, format.second, false);
+        check_classic_file(format.first, format.second, true);
+    }
+}
+
+// Reads queued on the I/O service while the executor is blocked are
+// dispatched together. Overlapping and touching requests are read once
+// through their bounding hyperslab if it is at most twice their size, and
+// strided requests are read on their own.
+void test_io_service()
+{
+    auto f = make_grid_file();
+    ncpp::dataset ds(f);
+    auto v = ds.vars["values"];
+
+    const std::vector<std::pair<ncpp::variable, const char *>> requests = {
+        { region(v, 0, 1, 0, 3, 0, 5), "first request" },
+        { region(v, 0, 1, 2, 5, 3, 8), "overlapping request" },
+        { region(v, 0, 1, 2, 5, 9, 11), "touching request" },
+        { region(v, 0, 1, 0, 3, 0, 5), "repeated request" },
+        { region(v, 4, 5, 7, 9, 0, 2), "disjoint request" },
+        { region(v, 4, 4, 0, 1, 5, 6), "corner request" },
+        { region(v, 5, 5, 2, 3, 7, 8), "request touching a corner, more than twice the size together" },
+        { region(v, 0, 1, 0, 3, 0, 11, 3), "strided request" },
+        { region(v, 0, 1, 1, 4, 1, 6, 2), "strided overlapping request" }
+    };
+
+    // Selections read coordinates, so they are made before the executor is
+    // blocked.
+    std::vector<std::vector<int>> expected;
+    for (const auto& r : requests)
+        expected.push_back(r.first.values<int>());
+    const auto expected_double = requests[0].first.values<double>();
+
+    ncpp::io_service io;
+    std::promise<void> gate;
+    std::shared_future<void> open = gate.get_future().share();
+    auto blocked = io.post([open] { open.wait(); });
+
+    std::vector<std::future<std::vector<int>>> results;
+    for (const auto& r : requests)
+        results.push_back(io.values<int>(r.first));
+    auto result_double = io.values<double>(requests[0].first);
+    gate.set_value();
+
+    blocked.get();
+    for (std::size_t i = 0; i < results.size(); ++i)
+        expect(results[i].get() == expected[i], requests[i].second);
+    expect(result_double.get() == expected_double, "request with another type");
+}
+
+// Read one element of a variable by its index in the file.
+template <class T>
+T read_element(const ncpp::variable& v, const ncpp::index_type& index)
+{
+    const ncpp::index_type count(index.size(), 1);
+    const ncpp::stride_type stride(index.size(), 1);
+    return ncpp::api::get_vars<std::vector<T>>(v.ncid(), v.varid(), index, count, stride).front();
+}
+
+// Requests added to an access planner are split at chunk boundaries, and
+// each chunk is read once for all requests that touch it.
+void test_access_planner()
+{
+    auto f = make_grid_file();
+    ncpp::dataset ds(f);
+    auto v = ds.vars["values"];
+    auto scalar = ds.vars["scalar"];
+
+    // Selections, each crossing chunk boundaries in every dimension.
+    const std::vector<std::pair<ncpp::variable, const char *>> selections = {
+        { v, "whole variable" },
+        { region(v, 1, 4, 3, 8, 4, 10), "selection" },
+        { region(v, 1, 3, 2, 6, 3, 9), "overlapping selection" },
+        { region(v, 0, 5, 0, 9, 1, 11, 3), "strided selection" },
+        { region(v, 3, 3, 7, 7, 4, 4), "single element" },
+        { scalar, "scalar variable" }
+    };
+
+    ncpp::access_planner planner;
+    std::vector<std::vector<int>> out;
+    for (const auto& s : selections)
+        out.emplace_back(s.first.size());
+    for (std::size_t i = 0; i < selections.size(); ++i)
+        planner.add(selections[i].first, out[i].data());
+
+    // Hyperslabs in file indexes, with strides larger than a chunk.
+    const ncpp::index_type start{ 1, 2, 1 }, count{ 2, 2, 2 };
+    const ncpp::stride_type stride{ 3, 5, 6 };
+    std::vector<int> strided(2 * 2 * 2);
+    planner.add(v, start, count, stride, strided.data());
+    std::vector<double> converted(out[1].size());
+    planner.add(selections[1].first, converted.data());
+
+    expect(planner.size() == selections.size() + 2, "planner size");
+    planner.execute();
+    expect(planner.empty(), "planner is empty after execute");
+
+    for (std::size_t i = 0; i < selections.size(); ++i)
+        expect(out[i] == selections[i].first.values<int>(), selections[i].second);
+    expect(strided == ncpp::api::get_vars<std::vector<int>>(v.ncid(), v.varid(), start, count, stride),
+           "hyperslab with strides larger than a chunk");
+    expect(converted == selections[1].first.values<double>(), "selection with another type");
+}
+
+// Compare an indexed selection with reads of single elements.
+void check_indexed(const ncpp::indexed_variable& iv, const char *what)
+{
+    const auto values = iv.values<int>();
+    const auto shape = iv.shape();
+    const auto& base = iv.base();
+
+    bool equal = (values.size() == iv.size());
+    ncpp::index_type index(shape.size());
+    for (std::size_t n = 0; equal && n < values.size(); ++n) {
+        const auto position = ncpp::api::unravel_index(n, shape);
+        for (std::size_t d = 0; d < shape.size(); ++d)
+            index[d] = base.start()[d] + iv.indexes(d)[position[d]] * static_cast<std::size_t>(base.stride()[d]);
+        equal = (values[n] == read_element<int>(base, index));
+    }
+    expect(equal, what);
+}
+
+// Index lists are read as strided hyperslabs, or chunk by chunk when there
+// are more hyperslabs than chunks and the selection is at least half of its
+// bounding box. The grid has 3 x 3 x 3 chunks.
+void test_indexed_variable()
+{
+    auto f = make_grid_file();
+    ncpp::dataset ds(f);
+    auto v = ds.vars["values"];
+
+    // Hyperslabs.
+    check_indexed(v.isel("x", { 7, 2, 2, 9, 0 }), "unsorted and repeated indexes");
+    check_indexed(v.isel("y", { 0, 1, 2, 4, 6, 9 }), "indexes with varying steps");
+    check_indexed(v.where("time", { true, false, true, true, false, true }), "mask");
+    check_indexed(v.isel("x", { 11, 3, 3, 8 }).isel("y", { 9, 0, 5 }).where("time", { false, true, true, false, true, false }),
+                  "indexes and mask on several dimensions");
+    check_indexed(v.isel("x", { 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 }).isel("y", { 9, 0 }).isel("time", { 5, 0 }),
+                  "sparse selection with more hyperslabs than chunks");
+    check_indexed(v.isel("x", { 5, 4, 3 }).isel("x", { 2, 0 }), "indexes of indexes");
+
+    // Chunks.
+    check_indexed(v.isel("y", { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 }).isel("x", { 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 }),
+                  "dense reversed indexes");
+    check_indexed(region(v, 1, 4, 1, 8, 0, 11, 2).isel("x", { 5, 4, 3, 3, 2, 1, 0 }).isel("y", { 7, 6, 5, 4, 3, 2, 1, 0, 0 }),
+                  "dense repeated indexes of a strided selection");
+    check_indexed(v.where("x", { true, true, false, true, true, false, true, true, false, true, true, true })
+                   .isel("y", { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8 }).isel("time", { 5, 4, 3, 2, 1, 0 }),
+                  "dense mask and swapped indexes");
+}
+
+// Split a strided range at chunk boundaries one element at a time.
+std::vector<std::pair<std::size_t, std::size_t>>
+chunk_segments(std::size_t start, std::size_t count, std::ptrdiff_t stride, std::size_t chunklen)
+{
+    std::vector<std::pair<std::size_t, std::size_t>> segments;
+    for (std::size_t k = 0; k < count; ++k) {
+        const std::size_t chunk = (start + k * static_cast<std::size_t>(stride)) / chunklen;
+        if (k != 0 && chunk == (start + (k - 1) * static_cast<std::size_t>(stride)) / chunklen)
+            ++segments.back().second;
+        else
+            segments.emplace_back(k, 1);
+    }
+    return segments;
+}
+
+// Segments are positions within the range, aligned to the chunk grid.
+void test_chunk_segments()
+{
+    using segments = std::vector<std::pair<std::size_t, std::size_t>>;
+    expect(ncpp::api::compute_chunk_segments(7, 6, 1, 5) == segments{ { 0, 3 }, { 3, 3 } }, "nonzero start");
+    expect(ncpp::api::compute_chunk_segments(1, 4, 7, 5) == segments{ { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 } },
+           "stride larger than a chunk");
+    expect(ncpp::api::compute_chunk_segments(3, 4, 12, 4) == segments{ { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 } },
+           "stride skipping chunks");
+    expect(ncpp::api::compute_chunk_segments(4, 0, 3, 5).empty(), "zero count");
+
+    bool equal = true;
+    for (std::size_t chunklen = 1; chunklen <= 6; ++chunklen)
+        for (std::size_t start = 0; start <= 13; ++start)
+            for (std::ptrdiff_t stride = 1; stride <= 13; ++stride)
+                for (std::size_t count = 0; count <= 9; ++count)
+                    equal = equal && (ncpp::api::compute_chunk_segments(start, count, stride, chunklen) ==
+                                      chunk_segments(start, count, stride, chunklen));
+    expect(equal, "segments match element by element split");
+}
+
+// Blocks of a chunk iterator cover the selection once, each within a single
+// chunk, at positions relative to the start of the selection.
+void check_chunk_iterator(const ncpp::variable& sel, const char *what)
+{
+    const auto shape = sel.shape();
+    const auto expected = sel.values<int>();
+    const ncpp::index_type chunkshape{ 2, 4, 5 };
+
+    std::vector<int> covered(sel.size(), 0);
+    bool positions = true, chunks = true, values = true;
+    ncpp::chunk_iterator it(sel.ncid(), sel.varid(), sel.start(), shape, sel.stride(), chunkshape);
+    std::vector<int> buffer;
+    while (it.next()) {
+        const auto position = it.position(), start = it.start(), count = it.count();
+        it.read(buffer);
+        for (std::size_t d = 0; d < shape.size(); ++d) {
+            const std::size_t step = static_cast<std::size_t>(sel.stride()[d]);
+            const std::size_t last = start[d] + (count[d] - 1) * step;
+            positions = positions && (start[d] == sel.start()[d] + position[d] * step);
+            chunks = chunks && (start[d] / chunkshape[d] == last / chunkshape[d]);
+        }
+        for (std::size_t n = 0; n < buffer.size(); ++n) {
+            auto index = ncpp::api::unravel_index(n, count);
+            for (std::size_t d = 0; d < shape.size(); ++d)
+                index[d] += position[d];
+            const std::size_t offset = ncpp::api::ravel_index(index, shape);
+            ++covered[offset];
+            values = values && (buffer[n] == expected[offset]);
+        }
+    }
+
+    const std::string name(what);
+    expect(positions, (name + ": position is relative to the selection start").c_str());
+    expect(chunks, (name + ": block within a single chunk").c_str());
+    expect(values, (name + ": block values").c_str());
+    expect(it.offset() == sel.size(), (name + ": blocks add up to the selection size").c_str());
+    expect(std::all_of(covered.begin(), covered.end(), [](int c) { return c == 1; }),
+           (name + ": selection covered once").c_str());
+}
+
+void test_chunk_iterator()
+{
+    auto f = make_grid_file();
+    ncpp::dataset ds(f);
+    auto v = ds.vars["values"];
+
+    check_chunk_iterator(v, "whole variable");
+    check_chunk_iterator(region(v, 1, 5, 3, 9, 2, 11, 3), "strided selection");
+    check_chunk_iterator(region(v, 3, 3, 1, 8, 1, 11, 6), "selection with a single element dimension");
+
+    // Positions round trip through linear offsets, including dimensions
+    // with a single element.
+    const ncpp::index_type shape{ 3, 1, 4, 1, 2 };
+    bool equal = true;
+    for (std::size_t n = 0; n < ncpp::api::compute_size(shape); ++n)
+        equal = equal && (ncpp::api::ravel_index(ncpp::api::unravel_index(n, shape), shape) == n);
+    expect(equal, "ravel and unravel positions");
+}
+
+// Unit vector of a location, computed as in the spatial index so that
+// distances compare equal.
+std::array<double, 3> unit_vector(double lat, double lon)
+{
+    constexpr double deg = 3.14159265358979323846 / 180.0;
+    const double c = std::cos(lat * deg);
+    return { c * std::cos(lon * deg), c * std::sin(lon * deg), std::sin(lat * deg) };
+}
+
+bool valid_location(double lat, double lon)
+{
+    return std::isfinite(lat) && std::isfinite(lon) && std::abs(lat) <= 90.0 && std::abs(lon) <= 720.0;
+}
+
+// Offset of the nearest valid point by linear scan, the first on ties.
+std::size_t scan_nearest(const std::vector<double>& lat, const std::vector<double>& lon, double qlat, double qlon)
+{
+    const auto q = unit_vector(qlat, qlon);
+    std::size_t best = 0;
+    double best_dist = std::numeric_limits<double>::infinity();
+    for (std::size_t n = 0; n < lat.size(); ++n) {
+        if (!valid_location(lat[n], lon[n]))
+            continue;
+        const auto p = unit_vector(lat[n], lon[n]);
+        const double dx = q[0] - p[0], dy = q[1] - p[1], dz = q[2] - p[2];
+        const double d = dx * dx + dy * dy + dz * dz;
+        if (d < best_dist) {
+            best = n;
+            best_dist = d;
+        }
+    }
+    return best;
+}
+
+// Offsets of the valid points within a box by linear scan.
+std::vector<std::size_t> scan_within(const std::vector<double>& lat, const std::vector<double>& lon,
+                                     double min_lat, double max_lat, double min_lon, double max_lon)
+{
+    if (min_lat > max_lat)
+        std::swap(min_lat, max_lat);
+    double width = max_lon - min_lon;
+    if (width < 0.0)
+        width += 360.0;
+
+    std::vector<std::size_t> result;
+    for (std::size_t n = 0; n < lat.size(); ++n) {
+        if (!valid_location(lat[n], lon[n]) || lat[n] < min_lat || lat[n] > max_lat)
+            continue;
+        if (width >= 360.0 || std::fmod(std::fmod(lon[n] - min_lon, 360.0) + 360.0, 360.0) <= width)
+            result.push_back(n);
+    }
+    return result;
+}
+
+// Queries on a spatial index match a linear scan of the points.
+void test_spatial_index()
+{
+    // Regular points with longitudes in several conventions, including the
+    // poles and the antimeridian, repeated at later offsets for ties.
+    std::vector<double> lat, lon;
+    for (int i = -90; i <= 90; i += 15) {
+        for (int j = -180; j <= 540; j += 30) {
+            lat.push_back(i);
+            lon.push_back(j);
+        }
+    }
+    const std::size_t nregular = lat.size();
+    for (std::size_t n = 0; n < nregular; n += 7) {
+        lat.push_back(lat[n]);
+        lon.push_back(lon[n]);
+    }
+
+    // Pseudo-random points, and invalid points that are skipped.
+    std::uint32_t seed = 12345;
+    auto uniform = [&](double lo, double hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<double>(seed >> 8) / static_cast<double>(1u << 24);
+    };
+    for (int n = 0; n < 500; ++n) {
+        lat.push_back(uniform(-90, 90));
+        lon.push_back(uniform(-720, 720));
+    }
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    const std::vector<std::pair<double, double>> invalid = {
+        { nan, 0 }, { 0, nan }, { inf, 10 }, { 10, -inf }, { 90.5, 0 }, { -91, 0 }, { 0, 721 }, { 0, -800 }
+    };
+    for (const auto& p : invalid) {
+        lat.push_back(p.first);
+        lon.push_back(p.second);
+    }
+
+    ncpp::spatial_index index(lat, lon, { lat.size() });
+    expect(index.size() == lat.size() - invalid.size(), "invalid points are skipped");
+
+    // Boxes, including longitude wrap, polar caps, full circles, reversed
+    // latitudes, zero width and edges on grid points.
+    const std::vector<std::array<double, 4>> boxes = {
+        { -30, 30, -60, 60 }, { 10, 50, 150, -150 }, { -45, 45, 350, 10 }, { -90, 90, 170, -170 },
+        { 75, 90, -180, 180 }, { -90, -60, 0, 90 }, { 60, 90, 90, -90 }, { 89, 90, 0, 1 },
+        { -90, 90, -180, 180 }, { 30, -30, 200, 300 }, { 0, 45, 30, 30 }, { -15, 15, 540, 600 },
+        { -60, 0, -400, -300 }, { 45, 45, -180, 180 }, { -90, -90, 10, 20 }
+    };
+    bool equal = true;
+    for (const auto& b : boxes)
+        equal = equal && (index.within(b[0], b[1], b[2], b[3]) == scan_within(lat, lon, b[0], b[1], b[2], b[3]));
+    for (int n = 0; n < 200; ++n) {
+        const double lat0 = uniform(-90, 90), lat1 = uniform(-90, 90);
+        const double lon0 = uniform(-360, 360), lon1 = uniform(-360, 360);
+        equal = equal && (index.within(lat0, lat1, lon0, lon1) == scan_within(lat, lon, lat0, lat1, lon0, lon1));
+    }
+    expect(equal, "within matches a linear scan");
+
+    // Nearest points, including tied and polar queries.
+    const std::vector<std::pair<double, double>> queries = {
+        { 90, 0 }, { -90, 123 }, { 89.9, -170 }, { 0, 180 }, { 0, -180 }, { 45, 90 }, { 45, 450 },
+        { -15, -210 }, { 30, 15 }, { 7.5, 15 }, { 0, 725 }, { -60, 300 }, { -75, -90 }, { -75, 120 },
+        { -74.9, 120.1 }
+    };
+    equal = true;
+    for (const auto& q : queries)
+        equal = equal && (index.nearest(q.first, q.second) == scan_nearest(lat, lon, q.first, q.second));
+    for (int n = 0; n < 200; ++n) {
+        const double qlat = uniform(-90, 90), qlon = uniform(-720, 720);
+        equal = equal && (index.nearest(qlat, qlon) == scan_nearest(lat, lon, qlat, qlon));
+    }
+    expect(equal, "nearest matches a linear scan");
+
+    bool thrown = false;
+    try {
+        index.nearest(nan, 0);
+    }
+    catch (const std::exception&) {
+        thrown = true;
+    }
+    expect(thrown, "nearest to an invalid location");
+}
+
+// A coordinate view matches the eager cartesian product of its columns.
+void test_coordinate_view()
+{
+    using view_type = ncpp::coordinate_view<double, int, std::string>;
+    view_type::columns_type columns{ { 0.5, 1.5, 2.5 }, { 10, 20, 30, 40 }, { "a", "b" } };
+    const view_type view(columns);
+    const auto expected = ncpp::detail::tuple_cartesian_product(columns);
+
+    expect(view.size() == expected.size(), "coordinate view size");
+    expect(std::vector<view_type::value_type>(view.begin(), view.end()) == expected, "forward iteration");
+
+    bool equal = true;
+    for (std::size_t n = 0; n < expected.size(); ++n)
+        equal = equal && (view[n] == expected[n]) && (view.begin()[n] == expected[n]);
+    expect(equal, "access by offset");
+
+    // Steps in both directions, followed by increments from the new position.
+    equal = true;
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(expected.size());
+    for (std::ptrdiff_t k = 0; k < size; ++k) {
+        for (std::ptrdiff_t j = 0; j <= k; ++j) {
+            auto it = view.begin();
+            it += k;
+            equal = equal && (*it == expected[k]);
+            it -= j;
+            equal = equal && (*it == expected[k - j]) && (it - view.begin() == k - j);
+            ++it;
+            equal = equal && (it == view.begin() + (k - j + 1));
+            if (it != view.end())
+                equal = equal && (*it == expected[k - j + 1]);
+        }
+    }
+    expect(equal, "iterator steps");
+
+    auto last = view.end();
+    --last;
+    expect(*last == expected.back(), "decrement from end");
+    ++last;
+    expect(last == view.end() && view.end() - view.begin() == size, "increment to end");
+    expect(view.begin() + size == view.end() && view.end() - size == view.begin(), "end from offsets");
+
+    bool thrown = false;
+    try {
+        view.at(view.size());
+    }
+    catch (const std::exception&) {
+        thrown = true;
+    }
+    expect(thrown, "coordinates past the end");
+
+    // A dimension without coordinates makes the view empty.
+    view_type::columns_type empty_columns{ { 0.5, 1.5 }, {}, { "a" } };
+    const view_type empty_view(empty_columns);
+    expect(empty_view.empty() && empty_view.begin() == empty_view.end(), "empty dimension");
+    expect(ncpp::detail::tuple_cartesian_product(empty_columns).empty(), "empty cartesian product");
+}
+
+// Valid data test by the CF rules, one value at a time.
+template <class T>
+bool scalar_valid(const ncpp::value_mask<T>& mask, T x)
+{
+    if (x != x)
+        return false;
+    return (!mask.fill_value || x != *mask.fill_value) && (!mask.missing_value || x != *mask.missing_value) &&
+           (!mask.valid_min || x >= *mask.valid_min) && (!mask.valid_max || x <= *mask.valid_max);
+}
+
+// Vectorized validation and bit packing match scalar loops.
+void test_validate_kernels()
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> values(150);
+    for (std::size_t n = 0; n < values.size(); ++n)
+        values[n] = static_cast<double>(n) - 75.0;
+    for (std::size_t n : { 3, 64, 100, 149 })
+        values[n] = nan;
+    for (std::size_t n : { 0, 65, 127 })
+        values[n] = -999.0;
+    values[10] = 1e20;
+
+    std::vector<ncpp::value_mask<double>> masks(5);
+    masks[1].fill_value = -999.0;
+    masks[2].valid_min = -50.0;
+    masks[2].valid_max = 50.0;
+    masks[3].valid_min = 0.0;
+    masks[4].fill_value = -999.0;
+    masks[4].missing_value = 1e20;
+    masks[4].valid_max = 60.0;
+
+    bool equal = true;
+    std::vector<unsigned char> flags(values.size());
+    for (const auto& mask : masks) {
+        mask.validate(values.data(), values.size(), flags.data());
+        for (std::size_t n = 0; n < values.size(); ++n)
+            equal = equal && (flags[n] == scalar_valid(mask, values[n])) &&
+                    (mask.is_valid(values[n]) == scalar_valid(mask, values[n]));
+    }
+    expect(equal, "validate matches a scalar test");
+
+    ncpp::value_mask<short> range;
+    range.valid_min = -5;
+    range.valid_max = 5;
+    const std::vector<short> shorts{ -32767, -6, -5, 0, 5, 6, 32767 };
+    std::vector<unsigned char> short_flags(shorts.size());
+    range.validate(shorts.data(), shorts.size(), short_flags.data());
+    expect(short_flags == std::vector<unsigned char>{ 0, 0, 1, 1, 1, 0, 0 }, "validate integers in range");
+
+    // Two consecutive ranges, as for the rows of a block, with the split
+    // and the end inside and on word boundaries.
+    std::vector<unsigned char> in(300);
+    for (std::size_t n = 0; n < in.size(); ++n)
+        in[n] = static_cast<unsigned char>((n * 7 + n / 5) % 3 == 0 ? 0 : n % 4 + 1);
+    equal = true;
+    for (std::size_t pos : { 0, 1, 37, 63, 64, 100, 128 }) {
+        for (std::size_t n : { 0, 1, 13, 63, 64, 65, 127, 128, 150 }) {
+            std::vector<std::uint64_t> bits((pos + n + 63) / 64 + 1, 0);
+            ncpp::detail::pack_bits(in.data(), pos, bits.data(), 0);
+            ncpp::detail::pack_bits(in.data() + pos, n, bits.data(), pos);
+            for (std::size_t k = 0; k < bits.size() * 64; ++k) {
+                const bool bit = (bits[k / 64] >> (k % 64)) & 1;
+                equal = equal && (bit == (k < pos + n && in[k] != 0));
+            }
+        }
+    }
+    expect(equal, "pack_bits matches a scalar loop");
+}
+
+// Variables with a fill value, a valid range, packing, NaN and a size that
+// is not a multiple of 64, with coordinates equal to their indexes.
+ncpp::file make_masked_file()
+{
+    auto f = ncpp::file::create_memory("masked");
+    const int ncid = f.ncid();
+
+    const std::size_t ny = 10, nx = 13;
+    const int y = define_dimension(ncid, "y", ny);
+    const int x = define_dimension(ncid, "x", nx);
+    const int y_id = define_variable(ncid, "y", NC_DOUBLE, { y });
+    const int x_id = define_variable(ncid, "x", NC_DOUBLE, { x });
+    const int filled_id = define_variable(ncid, "filled", NC_FLOAT, { y, x });
+    const int ranged_id = define_variable(ncid, "ranged", NC_SHORT, { y, x });
+    const int packed_id = define_variable(ncid, "packed", NC_SHORT, { y, x });
+    const std::size_t filled_chunks[] = { 3, 4 }, ranged_chunks[] = { 4, 5 };
+    ncpp::check(nc_def_var_chunking(ncid, filled_id, NC_CHUNKED, filled_chunks));
+    ncpp::check(nc_def_var_chunking(ncid, ranged_id, NC_CHUNKED, ranged_chunks));
+    ncpp::check(nc_def_var_chunking(ncid, packed_id, NC_CHUNKED, filled_chunks));
+    const float fill = -999.0f;
+    const short range[] = { -50, 50 }, packed_fill = -1;
+    const double scale = 0.5, offset = 10.0;
+    ncpp::check(nc_put_att(ncid, filled_id, "_FillValue", NC_FLOAT, 1, &fill));
+    ncpp::check(nc_put_att(ncid, ranged_id, "valid_range", NC_SHORT, 2, range));
+    ncpp::check(nc_put_att(ncid, packed_id, "_FillValue", NC_SHORT, 1, &packed_fill));
+    ncpp::check(nc_put_att(ncid, packed_id, "scale_factor", NC_DOUBLE, 1, &scale));
+    ncpp::check(nc_put_att(ncid, packed_id, "add_offset", NC_DOUBLE, 1, &offset));
+    ncpp::check(nc_enddef(ncid));
+
+    std::vector<double> yc(ny), xc(nx);
+    for (std::size_t n = 0; n < ny; ++n)
+        yc[n] = static_cast<double>(n);
+    for (std::size_t n = 0; n < nx; ++n)
+        xc[n] = static_cast<double>(n);
+    ncpp::check(nc_put_var_double(ncid, y_id, yc.data()));
+    ncpp::check(nc_put_var_double(ncid, x_id, xc.data()));
+
+    std::vector<float> filled(ny * nx);
+    std::vector<short> ranged(ny * nx), packed(ny * nx);
+    for (std::size_t n = 0; n < filled.size(); ++n) {
+        filled[n] = (n % 7 == 0) ? fill : (n % 11 == 0) ? std::numeric_limits<float>::quiet_NaN()
+                                                        : static_cast<float>(n) * 0.5f;
+        ranged[n] = static_cast<short>(static_cast<int>(n) - 65);
+        packed[n] = (n % 9 == 0) ? packed_fill : static_cast<short>(static_cast<int>(n % 40) - 20);
+    }
+    ncpp::check(nc_put_var_float(ncid, filled_id, filled.data()));
+    ncpp::check(nc_put_var_short(ncid, ranged_id, ranged.data()));
+    ncpp::check(nc_put_var_short(ncid, packed_id, packed.data()));
+    return f;
+}
+
+// Compare a masked read with values() and a scalar valid data test.
+template <class T>
+void check_masked(const ncpp::variable& v, const char *what)
+{
+    const auto mask = v.mask<T>();
+    const auto masked = v.values_masked<T>();
+    const auto values = v.values<T>();
+
+    bool equal = (masked.data.size() == values.size()) && (masked.valid.size() == (values.size() + 63) / 64);
+    std::size_t count = 0;
+    for (std::size_t n = 0; equal && n < values.size(); ++n) {
+        const bool valid = scalar_valid(mask, values[n]);
+        count += valid;
+        equal = (masked.is_valid(n) == valid) &&
+                (std::memcmp(&masked.data[n], &values[n], sizeof(T)) == 0);
+    }
+    for (std::size_t k = values.size(); equal && k < masked.valid.size() * 64; ++k)
+        equal = !masked.is_valid(k);
+    expect(equal && masked.count() == count, what);
+}
+
+void test_masked_values()
+{
+    auto f = make_masked_file();
+    ncpp::dataset ds(f);
+    auto filled = ds.vars["filled"];
+    auto ranged = ds.vars["ranged"];
+
+    const auto fill_mask = filled.mask<float>();
+    expect(fill_mask.fill_value == -999.0f && !fill_mask.missing_value && !fill_mask.valid_min &&
+           !fill_mask.valid_max, "mask with a fill value only");
+    const auto range_mask = ranged.mask<short>();
+    expect(range_mask.valid_min == -50 && range_mask.valid_max == 50 && !range_mask.missing_value,
+           "mask with a valid range");
+
+    check_masked<float>(filled, "masked values with a fill value and NaN");
+    check_masked<short>(ranged, "masked values with a valid range");
+    check_masked<float>(filled.select(ncpp::selection<double>{"y", 2, 8}, ncpp::selection<double>{"x", 1, 12, 2}),
+                        "masked values of a strided selection");
+    check_masked<short>(ranged.select(ncpp::selection<double>{"y", 3, 7}), "masked values of a selection");
+}
+
+// Reduce valid values along the named dimensions with a scalar loop over
+// values_masked(), unpacking each value.
+std::vector<ncpp::statistics> scan_reduce(const ncpp::variable& v, const std::vector<std::string>& dimnames,
+                                          double scale, double offset)
+{
+    const auto shape = v.shape();
+    std::vector<bool> reduced;
+    for (const auto& dim : v.dims)
+        reduced.push_back(std::find(dimnames.begin(), dimnames.end(), dim.name()) != dimnames.end());
+    std::size_t size = 1;
+    for (std::size_t d = 0; d < shape.size(); ++d)
+        size *= reduced[d] ? 1 : shape[d];
+
+    std::vector<ncpp::statistics> result(size);
+    const auto masked = v.values_masked<double>();
+    for (std::size_t n = 0; n < masked.data.size(); ++n) {
+        if (!masked.is_valid(n))
+            continue;
+        const auto index = ncpp::api::unravel_index(n, shape);
+        std::size_t pos = 0;
+        for (std::size_t d = 0; d < shape.size(); ++d)
+            pos = reduced[d] ? pos : pos * shape[d] + index[d];
+
+        const double x = masked.data[n] * scale + offset;
+        auto& stats = result[pos];
+        ++stats.count;
+        stats.sum += x;
+        stats.min = std::min(stats.min, x);
+        stats.max = std::max(stats.max, x);
+    }
+    return result;
+}
+
+bool same_statistics(const ncpp::statistics& a, const ncpp::statistics& b)
+{
+    return a.count == b.count && a.sum == b.sum && a.min == b.min && a.max == b.max;
+}
+
+bool same_statistics(const std::vector<ncpp::statistics>& a, const std::vector<ncpp::statistics>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+        [](const ncpp::statistics& x, const ncpp::statistics& y) { return same_statistics(x, y); });
+}
+
+// Compare reductions, serial and on thread pools, with a scalar loop. The
+// values are multiples of 0.5, so sums are exact in any order.
+void check_reduce(const ncpp::variable& v, const std::vector<std::vector<std::string>>& dimlists,
+                  double scale, double offset, const char *what)
+{
+    ncpp::thread_pool one(1), many(4);
+    const std::string name(what);
+
+    std::vector<std::string> all;
+    for (const auto& dim : v.dims)
+        all.push_back(dim.name());
+    const auto expected = scan_reduce(v, all, scale, offset).front();
+    expect(same_statistics(v.reduce(), expected), (name + ": reduce").c_str());
+    expect(same_statistics(v.reduce(one), expected), (name + ": reduce on one thread").c_str());
+    expect(same_statistics(v.reduce(many), expected), (name + ": reduce on several threads").c_str());
+
+    bool equal = true;
+    for (const auto& dimnames : dimlists) {
+        const auto along = scan_reduce(v, dimnames, scale, offset);
+        equal = equal && same_statistics(v.reduce(dimnames), along) &&
+                same_statistics(v.reduce(dimnames, one), along) && same_statistics(v.reduce(dimnames, many), along);
+    }
+    expect(equal, (name + ": reduce along dimensions").c_str());
+}
+
+// Reductions skip invalid values and unpack the results.
+void test_reduce()
+{
+    auto f = make_masked_file();
+    ncpp::dataset ds(f);
+    const std::vector<std::vector<std::string>> dimlists = { {}, { "y" }, { "x" }, { "y", "x" } };
+    check_reduce(ds.vars["filled"], dimlists, 1.0, 0.0, "fill value and NaN");
+    check_reduce(ds.vars["ranged"], dimlists, 1.0, 0.0, "valid range");
+    check_reduce(ds.vars["packed"], dimlists, 0.5, 10.0, "packed values");
+    check_reduce(ds.vars["filled"].select(ncpp::selection<double>{"y", 1, 8}, ncpp::selection<double>{"x", 2, 12, 3}),
+                 dimlists, 1.0, 0.0, "strided selection");
+
+    auto g = make_grid_file();
+    ncpp::dataset grid(g);
+    auto v = grid.vars["values"];
+    const std::vector<std::vector<std::string>> grid_dimlists = {
+        { "time" }, { "y" }, { "x" }, { "time", "x" }, { "y", "x" }, { "time", "y", "x" }
+    };
+    check_reduce(v, grid_dimlists, 1.0, 0.0, "grid");
+    check_reduce(region(v, 1, 4, 2, 9, 0, 11, 2), grid_dimlists, 1.0, 0.0, "grid selection");
+}
+
+// Compare values gathered at a list of indexes with reads of single elements.
+void check_gather(const ncpp::variable& v, const std::vector<ncpp::index_type>& indexes, const char *what)
+{
+    const auto values = v.gather<int>(indexes);
+
+    bool equal = (values.size() == indexes.size());
+    ncpp::index_type index(indexes.empty() ? 0 : indexes.front().size());
+    for (std::size_t i = 0; equal && i < indexes.size(); ++i) {
+        for (std::size_t d = 0; d < index.size(); ++d)
+            index[d] = v.start()[d] + indexes[i][d] * static_cast<std::size_t>(v.stride()[d]);
+        equal = (values[i] == read_element<int>(v, index));
+    }
+    expect(equal, what);
+}
+
+// Points are grouped by chunk and returned in request order.
+void test_gather()
+{
+    auto f = make_grid_file();
+    ncpp::dataset ds(f);
+    auto v = ds.vars["values"];
+
+    // Unsorted points in several chunks, with duplicates in the same and in
+    // different chunks, and points at chunk edges.
+    const std::vector<ncpp::index_type> points = {
+        { 5, 9, 11 }, { 0, 0, 0 }, { 3, 4, 5 }, { 0, 0, 0 }, { 1, 3, 4 },
+        { 2, 7, 1 }, { 5, 9, 11 }, { 4, 0, 10 }, { 1, 3, 4 }, { 0, 1, 1 },
+        { 3, 4, 5 }, { 2, 8, 6 }
+    };
+    check_gather(v, points, "unsorted and duplicate points");
+    check_gather(v, { { 4, 6, 7 }, { 4, 6, 7 }, { 4, 6, 7 } }, "repeated point");
+    check_gather(v, { { 3, 3, 3 } }, "single point");
+    expect(v.gather<int>({}).empty(), "no points");
+
+    // Indexes are relative to a strided selection.
+    auto strided = region(v, 1, 5, 1, 9, 1, 11, 3);
+    check_gather(strided, { { 4, 8, 2 }, { 0, 0, 0 }, { 2, 1, 2 }, { 4, 8, 2 }, { 1, 5, 0 }, { 0, 0, 0 } },
+                 "points in a strided selection");
+
+    bool thrown = false;
+    try {
+        v.gather<int>({ { 0, 0, 0 }, { 6, 0, 0 } });
+    }
+    catch (const std::exception&) {
+        thrown = true;
+    }
+    expect(thrown, "point outside the selection");
+}
+
+} // namespace
+
+int main()
+{
+#ifdef NCPP_USE_DATE_H
+    run(test_nearest_time, "nearest time");
+#endif // NCPP_USE_DATE_H
+    run(test_classic_file, "classic file");
+    run(test_io_service, "I/O service");
+    run(test_chunk_segments, "chunk segments");
+    run(test_chunk_iterator, "chunk iterator");
+    run(test_access_planner, "access planner");
+    run(test_indexed_variable, "indexed variable");
+    run(test_gather, "gather");
+    run(test_spatial_index, "spatial index");
+    run(test_coordinate_view, "coordinate view");
+    run(test_validate_kernels, "validate kernels");
+    run(test_masked_values, "masked values");
+    run(test_reduce, "reduce");
+
+    if (failures != 0) {
+        std::cerr << failures << " test(s) failed\n";
+        return 1;
+    }
+
+    std::cout << "all tests passed\n";
+    return 0;
+}